@@ -23,15 +23,27 @@
 #include <list>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <algorithm>
 
 #include "../Geometry/Point.h"
 #include "../Geometry/Point2.h"
 #include "../Parser/StrUtil.h"
+#include "../Parser/SpanTokenizer.h"
+#include "../Parser/MappedFile.h"
+#include "../Parser/MeshParser.h"
+#include "../Parser/BufferedWriter.h"
 
 #include "Edge.h"
 #include "Vertex.h"
 #include "HalfEdge.h"
 #include "Face.h"
+#include "ElementList.h"
+#include "ElementPool.h"
+#include "EdgeTable.h"
+#include "IdTable.h"
+#include "Property.h"
+#include "SpatialOrder.h"
 
 namespace MeshLib {
 
@@ -115,72 +127,24 @@ namespace MeshLib {
 		typedef CEdge* tEdge;
 		typedef CFace* tFace;
 
-		std::string write_obj_dump() {
-			std::stringstream _os;
-
-			int vid = 1;
-			for (std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
-			{
-				tVertex v = *viter;
-				v->fakeId = vid++;
-			}
-
-			for (std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
-			{
-				tVertex v = *viter;
-
-				_os << "v";
-
-				for (int i = 0; i < 3; i++)
-				{
-					_os << " " << v->point()[i];
-				}
-				_os << std::endl;
-			}
-
-			for (std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
-			{
-				tVertex v = *viter;
-
-				_os << "vt";
-
-				for (int i = 0; i < 2; i++)
-				{
-					_os << " " << v->uv()[i];
-				}
-				_os << std::endl;
-			}
-
-			for (std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
-			{
-				tVertex v = *viter;
-
-				_os << "vn";
-
-				for (int i = 0; i < 3; i++)
-				{
-					_os << " " << v->normal()[i];
-				}
-				_os << std::endl;
-			}
-
-
-			for (std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter++)
-			{
-				tFace f = *fiter;
-
-				_os << "f";
-
-				tHalfEdge he = faceHalfedge(f);
-
-				do {
-					int vid = he->target()->fakeId;
-					_os << " " << vid << "/" << vid << "/" << vid;
-					he = halfedgeNext(he);
-				} while (he != f->halfedge());
-				_os << std::endl;
-			}
-			return _os.str();
+		/*!
+		The mesh as the text of an .obj file, for the debug snapshots. The text is
+		kept by the mesh, a new dump reuses the memory of the last one.
+		*/
+		const std::string& write_obj_dump() {
+			m_dump.clear();
+			write_obj_dump([this](const char* data, size_t size) { m_dump.append(data, size); });
+			return m_dump;
+		};
+		/*!
+		Stream the text of an .obj file to a callback, in chunks of at most the
+		given size, without building the whole text in memory.
+		*/
+		void write_obj_dump(const CBufferedWriter::Sink& sink, size_t chunk = 1 << 16) {
+			CBufferedWriter _os(chunk);
+			_os.open(sink);
+			write_obj(_os);
+			_os.close();
 		};
 
 		//constructor and destructor
@@ -190,6 +154,7 @@ namespace MeshLib {
 		CBaseMesh() {
 			m_with_normal = false;
 			m_with_texture = false;
+			m_reorder_on_load = false;
 		};
 		/*!
 		CBasemesh destructor
@@ -213,6 +178,8 @@ namespace MeshLib {
 		\param output the output .obj file name
 		*/
 		void write_obj(const char* output);
+		/*! Write the text of an .obj file to a writer. */
+		void write_obj(CBufferedWriter& os);
 
 		/*!
 		Read an .m file.
@@ -224,6 +191,8 @@ namespace MeshLib {
 		\param output the output .m file name
 		*/
 		void write_m(const char* output);
+		/*! Write the text of an .m file to a writer. */
+		void write_m(CBufferedWriter& os);
 
 		/*!
 		Read an .off file
@@ -235,6 +204,29 @@ namespace MeshLib {
 		\param output the output .off file name
 		*/
 		void write_off(const char* output);
+		/*! Write the text of an .off file to a writer. */
+		void write_off(CBufferedWriter& os);
+
+		/*!
+		Sort the vertex, edge and face lists along the Morton curve of the planar
+		coordinates of the vertices, edge midpoints and face centroids. Only the
+		iteration order changes: the elements and their handles stay where the pools
+		put them, so walks over the neighbours of an element are not more cache local.
+		Loops over the lists, like the smoothing sweeps and the writers, see the new order.
+		*/
+		void reorderElements();
+		/*!
+		Create the vertices and faces of parsed records, in the order of the records.
+		The edges are matched by sorting the corners of the faces, the result is the
+		same as calling createVertex and createFace for each record.
+		\return false if a face refers to a missing vertex
+		*/
+		bool buildFromRecords(const CMeshRecords& records);
+		/*!
+		Whether the readers call reorderElements() after loading, false by default
+		so the lists keep the order of the file.
+		*/
+		bool& reorderOnLoad() { return m_reorder_on_load; };
 
 		//number of vertices, faces, edges
 		/*! number of vertices */
@@ -378,13 +370,6 @@ namespace MeshLib {
 		\return the halfedge targeting at v, which is the most ccw in halfedge of v.
 		*/
 		tHalfEdge   vertexHalfedge(tVertex v);
-		//v->edges
-		/*!
-		The edge list attaching to the vertex v, such that v is the first vertex of the edge
-		\param v the input vertex.
-		\return the reference to the edge list
-		*/
-		std::list<tEdge>& vertexEdges(tVertex v);
 
 		//edge->vertex
 		/*!
@@ -511,34 +496,64 @@ namespace MeshLib {
 		/*!
 		List of the edges of the mesh.
 		*/
-		std::list<tEdge>& edges() { return m_edges; };
+		CElementList<CEdge>& edges() { return m_edges; };
 		/*!
 		List of the faces of the mesh.
 		*/
-		std::list<tFace>& faces() { return m_faces; };
+		CElementList<CFace>& faces() { return m_faces; };
 		/*!
 		List of the vertices of the mesh.
 		*/
-		std::list<tVertex>& vertices() { return m_verts; };
+		CElementList<CVertex>& vertices() { return m_verts; };
+		/*!
+		Print the allocation statistics of the element pools.
+		*/
+		void reportPoolStatistics(std::ostream& os) {
+			os << "vertex pool:   " << m_vertex_pool.statistics() << std::endl;
+			os << "edge pool:     " << m_edge_pool.statistics() << std::endl;
+			os << "halfedge pool: " << m_halfedge_pool.statistics() << std::endl;
+			os << "face pool:     " << m_face_pool.statistics() << std::endl;
+		};
+		/*!
+		Properties attached to the elements, their values are dropped when an element is deleted.
+		*/
+		CPropertyRegistry<CVertex>& vertexProperties() { return m_vertex_properties; };
+		CPropertyRegistry<CEdge>& edgeProperties() { return m_edge_properties; };
+		CPropertyRegistry<CHalfEdge>& halfedgeProperties() { return m_halfedge_properties; };
+		CPropertyRegistry<CFace>& faceProperties() { return m_face_properties; };
 		/*
 			bool with_uv() { return m_with_texture; };
 			bool with_normal() { return m_with_normal; };
 		*/
 	protected:
 
-		/*! list of edges */
-		std::list<tEdge>                          m_edges;
-		/*! list of vertices */
-		std::list<tVertex>                        m_verts;
-		/*! list of faces */
-		std::list<tFace>							m_faces;
+		/*! pools recycling the elements released by the Euler operators */
+		CElementPool<CVertex>                     m_vertex_pool;
+		CElementPool<CEdge>                       m_edge_pool;
+		CElementPool<CHalfEdge>                   m_halfedge_pool;
+		CElementPool<CFace>                       m_face_pool;
+
+		/*! list of edges, elements are unlinked in constant time */
+		CElementList<CEdge>                       m_edges;
+		/*! list of vertices, elements are unlinked in constant time */
+		CElementList<CVertex>                     m_verts;
+		/*! list of faces, elements are unlinked in constant time */
+		CElementList<CFace>						m_faces;
 
 		//maps
 
 		/*! map between vetex and its id*/
-		std::map<int, tVertex>                    m_map_vert;
+		CIdTable<CVertex>                         m_map_vert;
 		/*! map between face and its id*/
-		std::map<int, tFace>						m_map_face;
+		CIdTable<CFace>							m_map_face;
+		/*! map between edge and the ids of its end vertices*/
+		CEdgeTable<CEdge>							m_edge_table;
+
+		/*! properties registered on the elements */
+		CPropertyRegistry<CVertex>                m_vertex_properties;
+		CPropertyRegistry<CEdge>                  m_edge_properties;
+		CPropertyRegistry<CHalfEdge>              m_halfedge_properties;
+		CPropertyRegistry<CFace>                  m_face_properties;
 		/*! Create a vertex
 		\param id Vertex id
 		\return pointer to the new vertex
@@ -548,16 +563,16 @@ namespace MeshLib {
 			if (id == -1) {
 				id = globalVid;
 			}
-			CVertex* v = new CVertex();
-			assert(v != NULL);
-			v->setId(id);
-			v->point() = pos;
-			if (m_map_vert.find(id) != m_map_vert.end()) {
+			if (m_map_vert.find(id) != NULL) {
 				cerr << "Duplicate id!" << endl;
 				exit(-1);
 			}
+			CVertex* v = m_vertex_pool.alloc();
+			assert(v != NULL);
+			v->setId(id);
+			v->point() = pos;
 			m_verts.push_back(v);
-			m_map_vert.insert(std::pair<int, CVertex*>(v->getId(), v));
+			m_map_vert.insert(v->getId(), v);
 			return v;
 		}
 
@@ -599,18 +614,23 @@ namespace MeshLib {
 		void      deleteFace(tFace  pFace);
 		void deleteEdge(tEdge edge);
 		void deleteVertex(tVertex pVertex) {
-			if (pVertex->halfedge()||pVertex->edges().size()>0) {
+			if (pVertex->halfedge()) {
 				cerr << "Cannot delete vertex with edges, must delete connect edges and halfedges first" << endl;
 				assert(false);
 			}
 			m_verts.remove(pVertex);
 			m_map_vert.erase(vertexId(pVertex));
-			delete pVertex;
+			m_vertex_properties.erase(pVertex);
+			m_vertex_pool.release(pVertex);
 		}
 		/*! whether the vertex is with texture coordinates */
 		bool      m_with_texture;
 		/*! whether the mesh is with normal */
 		bool      m_with_normal;
+		/*! whether the readers sort the elements along the Morton curve */
+		bool      m_reorder_on_load;
+		/*! text of the last write_obj_dump() */
+		std::string m_dump;
 
 		/*! label boundary vertices, edges, faces */
 		void labelBoundary(void);
@@ -948,47 +968,32 @@ CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::~CBaseMesh()
 {
 	//remove vertices
 
-	for (std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
+	for (typename CElementList<CVertex>::iterator viter = m_verts.begin(); viter != m_verts.end(); )
 	{
 		CVertex* pV = *viter;
-		delete pV;
+		viter = m_verts.erase(viter);
+		m_vertex_pool.release(pV);
 	}
-	m_verts.clear();
 
 	//remove faces
 
-	for (std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter++)
+	for (typename CElementList<CFace>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); )
 	{
 		CFace* pF = *fiter;
-
-		tHalfEdge he = faceHalfedge(pF);
-
-		std::list<CHalfEdge*> hes;
-		do {
-			he = halfedgeNext(he);
-			hes.push_back(he);
-		} while (he != pF->halfedge());
-
-		for (std::list<CHalfEdge*>::iterator hiter = hes.begin(); hiter != hes.end(); hiter++)
-		{
-			CHalfEdge* pH = *hiter;
-			delete pH;
-		}
-		hes.clear();
-
-		delete pF;
+		fiter = m_faces.erase(fiter);
+		m_face_pool.release(pF);
 	}
-	m_faces.clear();
 
-	//remove edges
-	for (std::list<CEdge*>::iterator eiter = m_edges.begin(); eiter != m_edges.end(); eiter++)
+	//remove edges and halfedges, boundary halfedges included
+	for (typename CElementList<CEdge>::iterator eiter = m_edges.begin(); eiter != m_edges.end(); )
 	{
 		CEdge* pE = *eiter;
-		delete pE;
+		eiter = m_edges.erase(eiter);
+		m_halfedge_pool.release(edgeHalfedge(pE, 0));
+		m_halfedge_pool.release(edgeHalfedge(pE, 1));
+		m_edge_pool.release(pE);
 	}
 
-	m_edges.clear();
-
 	//clear all the maps
 	m_map_vert.clear();
 	m_map_face.clear();
@@ -1015,114 +1020,37 @@ Read an .obj file.
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::read_obj(const char* filename)
 {
+	CMappedFile file;
+	if (!file.open(filename)) return;
 
-	std::fstream f(filename, std::fstream::in);
-	if (f.fail()) return;
-
-	char cmd[1024];
-
-	int  vid = 1;
-	int  fid = 1;
-
-	bool with_uv = false;
-	bool with_normal = false;
-
-	std::vector<CPoint2> uvs;
-	std::vector<CPoint> normals;
-
-
-	while (f.getline(cmd, 1024))
+	CMeshRecords records;
+	CMeshParser::parse_obj(file, records);
+	if (!buildFromRecords(records))
 	{
-		std::string line(cmd);
-		line = strutil::trim(line);
-
-		strutil::Tokenizer stokenizer(line, " \t\r\n");
-
-		stokenizer.nextToken();
-		std::string token = stokenizer.getToken();
-
-		if (token == "v")
-		{
-			CPoint p;
-			for (int i = 0; i < 3; i++)
-			{
-				stokenizer.nextToken();
-				token = stokenizer.getToken();
-				p[i] = strutil::parseString<float>(token);
-			}
-
-			CVertex* v = createVertex(vid++, p);
-			continue;
-		}
-
-
-		if (token == "vt")
-		{
-			with_uv = true;
-			CPoint2 uv;
-			for (int i = 0; i < 2; i++)
-			{
-				stokenizer.nextToken();
-				token = stokenizer.getToken();
-				uv[i] = strutil::parseString<float>(token);
-			}
-			uvs.push_back(uv);
-			continue;
-		}
-
-
-		if (token == "vn")
-		{
-			with_normal = true;
-
-			CPoint n;
-			for (int i = 0; i < 3; i++)
-			{
-				stokenizer.nextToken();
-				token = stokenizer.getToken();
-				n[i] = strutil::parseString<float>(token);
-			}
-			normals.push_back(n);
-			continue;
-		}
-
-
-
+		return;
+	}
 
-		if (token == "f")
+	//texture coordinates and normals of the corners, the last face wins
+	for (size_t f = 0; f < records.numFaces(); f++)
+	{
+		for (size_t c = records.faceStart[f]; c < records.faceStart[f + 1]; c++)
 		{
-			CVertex* v[3];
-			for (int i = 0; i < 3; i++)
-			{
-				stokenizer.nextToken();
-				token = stokenizer.getToken();
-
-
-				strutil::Tokenizer tokenizer(token, " /\t\r\n");
-
-				int ids[3];
-				int k = 0;
-				while (tokenizer.nextToken())
-				{
-					std::string token = tokenizer.getToken();
-					ids[k] = strutil::parseString<int>(token);
-					k++;
-				}
-
-
-				v[i] = m_map_vert[ids[0]];
-				if (with_uv)
-					v[i]->uv() = uvs[ids[1] - 1];
-				if (with_normal)
-					v[i]->normal() = normals[ids[2] - 1];
-			}
-			createFace(v);
+			CVertex* v = m_map_vert.find(records.cornerVertex[c]);
+			int uv = records.cornerUV[c];
+			if (uv >= 0 && uv < records.faceUVCount[f])
+				v->uv() = records.uvs[uv];
+			int normal = records.cornerNormal[c];
+			if (normal >= 0 && normal < records.faceNormalCount[f])
+				v->normal() = records.normals[normal];
 		}
 	}
 
-	f.close();
+	file.close();
 
 	labelBoundary();
+	if (m_reorder_on_load) {
+		reorderElements();
+	}
 }
 
 //access id->v
@@ -1134,7 +1062,7 @@ Access a vertex by its id
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 CVertex* CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::idVertex(int id)
 {
-	return m_map_vert[id];
+	return m_map_vert.find(id);
 };
 
 //access v->id
@@ -1158,7 +1086,7 @@ inline int CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::vertexId(tVertex   v)
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 CFace* CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::idFace(int id)
 {
-	return m_map_face[id];
+	return m_map_face.find(id);
 };
 
 //acess f->id
@@ -1182,15 +1110,14 @@ inline int CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::faceId(tFace   f)
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 CEdge* CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::createEdge(tVertex  v1, tVertex  v2)
 {
-	tVertex pV = (v1->getId() < v2->getId()) ? v1 : v2;
-	std::list<CEdge*>& ledges = (std::list<CEdge*> &) pV->edges();
-	if (vertexEdge(v1, v2)) {
-		return vertexEdge(v1, v2);
+	CEdge* pE = vertexEdge(v1, v2);
+	if (pE) {
+		return pE;
 	}
 	// create a new edge
-	CEdge* e = new CEdge;
-	CHalfEdge* he1 = new CHalfEdge;
-	CHalfEdge* he2 = new CHalfEdge;
+	CEdge* e = m_edge_pool.alloc();
+	CHalfEdge* he1 = m_halfedge_pool.alloc();
+	CHalfEdge* he2 = m_halfedge_pool.alloc();
 	setVertex(he1, v2);
 	setVertex(he2, v1);
 	//setSourceVertex(he1, v1);
@@ -1203,7 +1130,7 @@ CEdge* CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::createEdge(tVertex  v1, tVer
 	setEdge(he2, e);
 
 	m_edges.push_back(e);
-	ledges.push_back(e);
+	m_edge_table.insert(v1->getId(), v2->getId(), e);
 	return e;
 };
 
@@ -1216,22 +1143,12 @@ Access an edge by its two end vertices
 \param v1 the other vertex of the edge
 \return the edge connecting both v0 and v1, NULL if no such edge exists.
 */
-//use the edge list associated with each vertex to locate the edge
+//use the edge table keyed by the vertex ids to locate the edge
 
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 inline CEdge* CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::vertexEdge(tVertex  v0, tVertex  v1)
 {
-	CVertex* pV = (v0->getId() < v1->getId()) ? v0 : v1;
-	std::list<CEdge*>& ledges = vertexEdges(pV);
-
-	for (std::list<CEdge*>::iterator eiter = ledges.begin(); eiter != ledges.end(); eiter++)
-	{
-		CEdge* pE = *eiter;
-		CHalfEdge* pH = edgeHalfedge(pE, 0);
-		if (pH->source() == v0 && pH->target() == v1) return pE;
-		if (pH->source() == v1 && pH->target() == v0) return pE;
-	}
-	return NULL;
+	return m_edge_table.find(v0->getId(), v1->getId());
 };
 
 /*!
@@ -1257,19 +1174,6 @@ inline CHalfEdge* CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::vertexHalfedge(tV
 };
 
 
-/*!
-Access the edge list of a vertex, {e} such that e->vertex1() == v
-\param v vertex
-\return the list of adjacent edges
-*/
-
-//access vertex->edges
-template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
-inline std::list<CEdge*>& CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::vertexEdges(tVertex  v0)
-{
-	return (std::list<CEdge*> &)v0->edges();
-};
-
 //access vertex->halfedge
 /*!
 	The halfedge targeting at a vertex.
@@ -1284,170 +1188,73 @@ inline CHalfEdge* CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::vertexHalfedge(tV
 
 /*!
 	Read an .m file.
+	The file is memory mapped and parsed in parallel chunks into CMeshRecords,
+	then the mesh is built from the records by buildFromRecords.
 	\param input the input obj file name
 	*/
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::read_m(const char* input)
 {
-	std::fstream is(input, std::fstream::in);
+	CMappedFile file;
 
-	if (is.fail())
+	if (!file.open(input))
 	{
 		fprintf(stderr, "Error in opening file %s\n", input);
 		return;
 	}
 
-	char buffer[MAX_LINE];
-	int id;
-
-	while (is.getline(buffer, MAX_LINE))
+	CMeshRecords records;
+	CMeshParser::parse_m(file, records);
+	if (!buildFromRecords(records))
 	{
+		return;
+	}
 
-		std::string line(buffer);
-		line = strutil::trim(line);
-
-		strutil::Tokenizer stokenizer(line, " \r\n");
-
-		stokenizer.nextToken();
-		std::string token = stokenizer.getToken();
-
-		if (token == "Vertex")
-		{
-			stokenizer.nextToken();
-			token = stokenizer.getToken();
-			id = strutil::parseString<int>(token);
-
-			CPoint p;
-			for (int i = 0; i < 3; i++)
-			{
-				stokenizer.nextToken();
-				token = stokenizer.getToken();
-				p[i] = strutil::parseString<float>(token);
-			}
-
-			tVertex v = createVertex(id, p);
-			if (!stokenizer.nextToken("\t\r\n")) continue;
-			token = stokenizer.getToken();
-
-			int sp = (int)token.find("{");
-			int ep = (int)token.find("}");
-
-			if (sp >= 0 && ep >= 0)
-			{
-				v->string() = token.substr(sp + 1, ep - sp - 1);
-			}
-			continue;
-		}
-
-
-		if (token == "Face")
-		{
-			stokenizer.nextToken();
-			token = stokenizer.getToken();
-			id = strutil::parseString<int>(token);
-
-			std::vector<CVertex*> v;
-			while (stokenizer.nextToken())
-			{
-				token = stokenizer.getToken();
-				if (strutil::startsWith(token, "{")) break;
-				int vid = strutil::parseString<int>(token);
-				v.push_back(idVertex(vid));
-			}
-
-			tFace f = createFace(v, id);
-
-			if (strutil::startsWith(token, "{"))
-			{
-				f->string() = strutil::trim(token, "{}");
-			}
-			continue;
-		}
-
-		//read in edge attributes
-		if (token == "Edge")
-		{
-			stokenizer.nextToken();
-			token = stokenizer.getToken();
-			int id0 = strutil::parseString<int>(token);
-
-			stokenizer.nextToken();
-			token = stokenizer.getToken();
-			int id1 = strutil::parseString<int>(token);
-
-
-			CVertex* v0 = idVertex(id0);
-			CVertex* v1 = idVertex(id1);
-
-			tEdge edge = vertexEdge(v0, v1);
-
-			if (!stokenizer.nextToken("\t\r\n")) continue;
-			token = stokenizer.getToken();
-
-			int sp = (int)token.find("{");
-			int ep = (int)token.find("}");
-
-			if (sp >= 0 && ep >= 0)
-			{
-				edge->string() = token.substr(sp + 1, ep - sp - 1);
-			}
-			continue;
-		}
-
-		//read in edge attributes
-		if (token == "Corner")
-		{
-			stokenizer.nextToken();
-			token = stokenizer.getToken();
-			int vid = strutil::parseString<int>(token);
-
-			stokenizer.nextToken();
-			token = stokenizer.getToken();
-			int fid = strutil::parseString<int>(token);
-
-
-			CVertex* v = idVertex(vid);
-			CFace* f = idFace(fid);
-			tHalfEdge he = corner(v, f);
-
-
-			if (!stokenizer.nextToken("\t\r\n")) continue;
-			token = stokenizer.getToken();
-
-			int sp = (int)token.find("{");
-			int ep = (int)token.find("}");
+	//read in edge attributes
+	for (size_t i = 0; i < records.edgeString.size(); i++)
+	{
+		CVertex* v0 = idVertex(records.edgeVertex[2 * i]);
+		CVertex* v1 = idVertex(records.edgeVertex[2 * i + 1]);
+		tEdge edge = vertexEdge(v0, v1);
+		edge->string().assign(records.edgeString[i].begin, records.edgeString[i].end);
+	}
 
-			if (sp >= 0 && ep >= 0)
-			{
-				he->string() = token.substr(sp + 1, ep - sp - 1);
-			}
-			continue;
-		}
+	//read in corner attributes
+	for (size_t i = 0; i < records.traitCornerString.size(); i++)
+	{
+		CVertex* v = idVertex(records.traitCornerVertex[i]);
+		CFace* f = idFace(records.traitCornerFace[i]);
+		tHalfEdge he = corner(v, f);
+		he->string().assign(records.traitCornerString[i].begin, records.traitCornerString[i].end);
 	}
+	file.close();
 
 	labelBoundary();
+	if (m_reorder_on_load) {
+		reorderElements();
+	}
 	
 	//read in the traits
 
-	for (std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); ++viter)
+	for (typename CElementList<CVertex>::iterator viter = m_verts.begin(); viter != m_verts.end(); ++viter)
 	{
 		CVertex* v = *viter;
 		v->_from_string();
 	}
 
-	for (std::list<CEdge*>::iterator eiter = m_edges.begin(); eiter != m_edges.end(); ++eiter)
+	for (typename CElementList<CEdge>::iterator eiter = m_edges.begin(); eiter != m_edges.end(); ++eiter)
 	{
 		CEdge* e = *eiter;
 		e->_from_string();
 	}
 
-	for (std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); ++fiter)
+	for (typename CElementList<CFace>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); ++fiter)
 	{
 		CFace* f = *fiter;
 		f->_from_string();
 	}
 
-	for (std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter++)
+	for (typename CElementList<CFace>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter++)
 	{
 		CFace* pF = *fiter;
 
@@ -1466,27 +1273,47 @@ void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::read_m(const char* input)
 	*/
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::write_m(const char* output)
+{
+	CBufferedWriter _os;
+	if (!_os.open(output))
+	{
+		fprintf(stderr, "Error is opening file %s\n", output);
+		return;
+	}
+	write_m(_os);
+	if (!_os.close())
+	{
+		fprintf(stderr, "Error in writing file %s\n", output);
+	}
+}
+
+/*!
+	Write the text of an .m file.
+	\param _os the writer
+	*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::write_m(CBufferedWriter& _os)
 {
 	//write traits to string
-	for (std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
+	for (typename CElementList<CVertex>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
 	{
 		CVertex* pV = *viter;
 		pV->_to_string();
 	}
 
-	for (std::list<CEdge*>::iterator eiter = m_edges.begin(); eiter != m_edges.end(); eiter++)
+	for (typename CElementList<CEdge>::iterator eiter = m_edges.begin(); eiter != m_edges.end(); eiter++)
 	{
 		CEdge* pE = *eiter;
 		pE->_to_string();
 	}
 
-	for (std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter++)
+	for (typename CElementList<CFace>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter++)
 	{
 		CFace* pF = *fiter;
 		pF->_to_string();
 	}
 
-	for (std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter++)
+	for (typename CElementList<CFace>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter++)
 	{
 		CFace* pF = *fiter;
 		CHalfEdge* pH = faceHalfedge(pF);
@@ -1496,17 +1323,8 @@ void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::write_m(const char* output)
 		} while (pH != faceHalfedge(pF));
 	}
 
-
-	std::fstream _os(output, std::fstream::out);
-	if (_os.fail())
-	{
-		fprintf(stderr, "Error is opening file %s\n", output);
-		return;
-	}
-
-
 	//remove vertices
-	for (std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
+	for (typename CElementList<CVertex>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
 	{
 		tVertex v = *viter;
 
@@ -1516,14 +1334,14 @@ void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::write_m(const char* output)
 		{
 			_os << " " << v->point()[i];
 		}
-		if (v->string().size() > 0)
+		if (v->hasString() && v->string().size() > 0)
 		{
 			_os << " " << "{" << v->string() << "}";
 		}
-		_os << std::endl;
+		_os << '\n';
 	}
 
-	for (std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter++)
+	for (typename CElementList<CFace>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter++)
 	{
 		tFace f = *fiter;
 
@@ -1538,20 +1356,20 @@ void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::write_m(const char* output)
 		{
 			_os << " " << "{" << f->string() << "}";
 		}
-		_os << std::endl;
+		_os << '\n';
 	}
 
-	for (std::list<CEdge*>::iterator eiter = m_edges.begin(); eiter != m_edges.end(); eiter++)
+	for (typename CElementList<CEdge>::iterator eiter = m_edges.begin(); eiter != m_edges.end(); eiter++)
 	{
 		tEdge e = *eiter;
 		if (e->string().size() > 0)
 		{
 			_os << "Edge " << edgeVertex1(e)->getId() << " " << edgeVertex2(e)->getId() << " ";
-			_os << "{" << e->string() << "}" << std::endl;
+			_os << "{" << e->string() << "}" << '\n';
 		}
 	}
 
-	for (std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter++)
+	for (typename CElementList<CFace>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter++)
 	{
 		tFace f = *fiter;
 
@@ -1561,14 +1379,12 @@ void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::write_m(const char* output)
 			if (he->string().size() > 0)
 			{
 				_os << "Corner " << he->vertex()->getId() << " " << f->id() << " ";
-				_os << "{" << he->string() << "}" << std::endl;
+				_os << "{" << he->string() << "}" << '\n';
 			}
 			he = halfedgeNext(he);
 		} while (he != f->halfedge());
 
 	}
-
-	_os.close();
 };
 
 
@@ -1580,21 +1396,34 @@ void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::write_m(const char* output)
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::write_obj(const char* output)
 {
-	std::fstream _os(output, std::fstream::out);
-	if (_os.fail())
+	CBufferedWriter _os;
+	if (!_os.open(output))
 	{
 		fprintf(stderr, "Error is opening file %s\n", output);
 		return;
 	}
+	write_obj(_os);
+	if (!_os.close())
+	{
+		fprintf(stderr, "Error in writing file %s\n", output);
+	}
+}
 
+/*!
+	Write the text of an .obj file.
+	\param _os the writer
+	*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::write_obj(CBufferedWriter& _os)
+{
 	int vid = 1;
-	for (std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
+	for (typename CElementList<CVertex>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
 	{
 		tVertex v = *viter;
 		v->fakeId = vid++;
 	}
 
-	for (std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
+	for (typename CElementList<CVertex>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
 	{
 		tVertex v = *viter;
 
@@ -1604,37 +1433,38 @@ void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::write_obj(const char* output)
 		{
 			_os << " " << v->point()[i];
 		}
-		_os << std::endl;
+		_os << '\n';
 	}
 
-	for (std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
+	for (typename CElementList<CVertex>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
 	{
 		tVertex v = *viter;
 
 		_os << "vt";
 
+		CPoint2 uv = v->hasUV() ? v->uv() : CPoint2();
 		for (int i = 0; i < 2; i++)
 		{
-			_os << " " << v->uv()[i];
+			_os << " " << uv[i];
 		}
-		_os << std::endl;
+		_os << '\n';
 	}
 
-	for (std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
+	for (typename CElementList<CVertex>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
 	{
 		tVertex v = *viter;
 
 		_os << "vn";
 
+		CPoint normal = v->hasNormal() ? v->normal() : CPoint();
 		for (int i = 0; i < 3; i++)
 		{
-			_os << " " << v->normal()[i];
+			_os << " " << normal[i];
 		}
-		_os << std::endl;
+		_os << '\n';
 	}
 
-
-	for (std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter++)
+	for (typename CElementList<CFace>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter++)
 	{
 		tFace f = *fiter;
 
@@ -1647,10 +1477,8 @@ void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::write_obj(const char* output)
 			_os << " " << vid << "/" << vid << "/" << vid;
 			he = halfedgeNext(he);
 		} while (he != f->halfedge());
-		_os << std::endl;
+		_os << '\n';
 	}
-
-	_os.close();
 }
 
 /*!
@@ -1660,33 +1488,44 @@ void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::write_obj(const char* output)
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::write_off(const char* output)
 {
-	std::fstream _os(output, std::fstream::out);
-	if (_os.fail())
+	CBufferedWriter _os;
+	if (!_os.open(output))
 	{
 		fprintf(stderr, "Error is opening file %s\n", output);
 		return;
 	}
+	write_off(_os);
+	if (!_os.close())
+	{
+		fprintf(stderr, "Error in writing file %s\n", output);
+	}
+}
 
-	_os << "OFF" << std::endl;
-	_os << m_verts.size() << " " << m_faces.size() << " " << m_edges.size() << std::endl;
-
+/*!
+	Write the text of an .off file.
+	\param _os the writer
+	*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::write_off(CBufferedWriter& _os)
+{
+	_os << "OFF" << '\n';
+	_os << m_verts.size() << " " << m_faces.size() << " " << m_edges.size() << '\n';
 
 	int vid = 0;
-	for (std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
+	for (typename CElementList<CVertex>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
 	{
 		tVertex v = *viter;
 		v->fakeId = vid++;
 	}
 
-	for (std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
+	for (typename CElementList<CVertex>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter++)
 	{
 		tVertex v = *viter;
-		_os << v->point()[0] << " " << v->point()[1] << " " << v->point()[2] << std::endl;
+		_os << v->point()[0] << " " << v->point()[1] << " " << v->point()[2] << '\n';
 		//_os << v->normal()[0] << " " << v->normal()[1]<< " " << v->normal()[2]<< std::endl;
 	}
 
-
-	for (std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter++)
+	for (typename CElementList<CFace>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter++)
 	{
 		tFace f = *fiter;
 
@@ -1699,10 +1538,8 @@ void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::write_off(const char* output)
 			_os << " " << vid;
 			he = halfedgeNext(he);
 		} while (he != f->halfedge());
-		_os << std::endl;
+		_os << '\n';
 	}
-
-	_os.close();
 };
 
 
@@ -1716,17 +1553,24 @@ template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::deleteFace(tFace  pFace)
 {
 	assert(pFace);
-	std::map<int, tFace>::iterator fiter = m_map_face.find(pFace->id());
 	m_faces.remove(pFace);
-	m_map_face.erase(fiter);
+	m_map_face.erase(pFace->id());
 	CHalfEdge* he = faceHalfedge(pFace);
 	CHalfEdge* he1 = he;
 	do {
 		he1->face() = NULL;
 		he1 = halfedgeNext(he1);
 	} while (he1 != he);
+	he1 = he;
+	do {
+		tVertex v = halfedgeTarget(he1);
+		v->faceCount()--;
+		if (pFace->degree() == 4) v->quadCount()--;
+		he1 = halfedgeNext(he1);
+	} while (he1 != he);
 
-	delete pFace;
+	m_face_properties.erase(pFace);
+	m_face_pool.release(pFace);
 };
 
 /*!
@@ -1736,100 +1580,27 @@ void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::deleteFace(tFace  pFace)
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::read_off(const char* input)
 {
-	std::fstream is(input, std::fstream::in);
+	CMappedFile file;
 
-	if (is.fail())
+	if (!file.open(input))
 	{
 		fprintf(stderr, "Error is opening file %s\n", input);
 		return;
 	}
 
-	char buffer[MAX_LINE];
-
-	//read in the first line "OFF"
-
-	while (is.getline(buffer, MAX_LINE))
-	{
-		std::string line(buffer);
-
-		strutil::Tokenizer stokenizer(line, " \r\n");
-
-		stokenizer.nextToken();
-		std::string token = stokenizer.getToken();
-		if (token == "OFF" || token == "NOFF") break;
-	}
-
-	int nVertices, nFaces, nEdges;
-
-	//read in Vertex Number, Face Number, Edge Number
-
-	is.getline(buffer, MAX_LINE);
-	std::string line(buffer);
-
-	strutil::Tokenizer stokenizer(line, " \r\n");
-
-	stokenizer.nextToken();
-	std::string token = stokenizer.getToken();
-	nVertices = strutil::parseString<int>(token);
-
-	stokenizer.nextToken();
-	token = stokenizer.getToken();
-	nFaces = strutil::parseString<int>(token);
-
-	stokenizer.nextToken();
-	token = stokenizer.getToken();
-	nEdges = strutil::parseString<int>(token);
-
-	//printf("V %d F %d E %d\n" , nVertices, nFaces, nEdges);
-
-
-	for (int id = 0; id < nVertices; id++)
-	{
-		is.getline(buffer, MAX_LINE);
-		std::string line(buffer);
-
-		strutil::Tokenizer stokenizer(line, " \r\n");
-		CPoint p;
-		for (int j = 0; j < 3; j++)
-		{
-			stokenizer.nextToken();
-			std::string token = stokenizer.getToken();
-			p[j] = strutil::parseString<float>(token);
-		}
-
-		CVertex* v = createVertex(id+1, p);
-	}
-
-
-	for (int id = 0; id < nFaces; id++)
+	CMeshRecords records;
+	CMeshParser::parse_off(file, records);
+	if (!buildFromRecords(records))
 	{
-
-		is.getline(buffer, MAX_LINE);
-		std::string line(buffer);
-
-		strutil::Tokenizer stokenizer(line, " \r\n");
-		stokenizer.nextToken();
-		std::string token = stokenizer.getToken();
-
-		int n = strutil::parseString<int>(token);
-		assert(n == 3);
-
-		CVertex* v[3];
-		for (int j = 0; j < 3; j++)
-		{
-			stokenizer.nextToken();
-			std::string token = stokenizer.getToken();
-			int vid = strutil::parseString<int>(token);
-			v[j] = idVertex(vid + 1);
-		}
-
-		createFace(v);
-
+		return;
 	}
 
-	is.close();
+	file.close();
 
 	labelBoundary();
+	if (m_reorder_on_load) {
+		reorderElements();
+	}
 
 };
 
@@ -1871,7 +1642,7 @@ void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::labelBoundary(void)
 
 	std::list<CVertex*> dangling_verts;
 	//Label boundary edges
-	for (std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); ++viter)
+	for (typename CElementList<CVertex>::iterator viter = m_verts.begin(); viter != m_verts.end(); ++viter)
 	{
 		tVertex     v = *viter;
 		if (v->halfedge() != NULL) continue;
@@ -1882,7 +1653,9 @@ void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::labelBoundary(void)
 	{
 		tVertex v = *viter;
 		m_verts.remove(v);
-		delete v;
+		m_map_vert.erase(vertexId(v));
+		m_vertex_properties.erase(v);
+		m_vertex_pool.release(v);
 		v = NULL;
 	}
 
@@ -1908,11 +1681,12 @@ CFace* CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::createFace(std::vector<tVert
 	if (id == -1) {
 		id = globalFid;
 	}
-	CFace* f = new CFace();
+	CFace* f = m_face_pool.alloc();
 	assert(f != NULL);
 	f->id() = id;
+	f->degree() = (int)v.size();
 	m_faces.push_back(f);
-	m_map_face.insert(std::pair<int, tFace>(f->id(), f));
+	m_map_face.insert(f->id(), f);
 	//create halfedges
 	std::vector<tHalfEdge> hes;
 
@@ -1924,6 +1698,8 @@ CFace* CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::createFace(std::vector<tVert
 		setHalfedge(f, pH);
 		//setHalfedge(v[i], pH);
 		hes.push_back(pH);
+		v[i]->faceCount()++;
+		if (v.size() == 4) v[i]->quadCount()++;
 	}
 
 	//linking to each other
@@ -1970,19 +1746,259 @@ void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::deleteEdge(tEdge edge) {
 	}
 	tVertex v1 = edgeVertex1(edge);
 	tVertex v2 = edgeVertex2(edge);
-	tVertex pV = (v1->getId() < v2->getId()) ? v1 : v2;
-	std::list<CEdge*>&ledges = (std::list<CEdge*> &) pV->edges();
-	auto it = std::find(ledges.begin(), ledges.end(), edge);
-	if (it != ledges.end()) {
-		ledges.erase(it);
-	}
-	else {
+	if (!m_edge_table.erase(v1->getId(), v2->getId())) {
 		assert(false);
 	}
 	m_edges.remove(edge);
-	delete edgeHalfedge(edge, 0);
-	delete edgeHalfedge(edge, 1);
-	delete edge;
+	m_halfedge_properties.erase(edgeHalfedge(edge, 0));
+	m_halfedge_properties.erase(edgeHalfedge(edge, 1));
+	m_edge_properties.erase(edge);
+	m_halfedge_pool.release(edgeHalfedge(edge, 0));
+	m_halfedge_pool.release(edgeHalfedge(edge, 1));
+	m_edge_pool.release(edge);
 	return;
 }
+
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::reorderElements()
+{
+	CMortonOrder order;
+	for (typename CElementList<CVertex>::iterator viter = m_verts.begin(); viter != m_verts.end(); ++viter)
+	{
+		order.add((*viter)->point());
+	}
+
+	std::vector<std::pair<uint32_t, CVertex*> > keyedVerts;
+	keyedVerts.reserve(m_verts.size());
+	for (typename CElementList<CVertex>::iterator viter = m_verts.begin(); viter != m_verts.end(); ++viter)
+	{
+		keyedVerts.push_back(std::make_pair(order.key((*viter)->point()), *viter));
+	}
+	CMortonOrder::sort(keyedVerts);
+	std::vector<CVertex*> verts(keyedVerts.size());
+	for (size_t i = 0; i < keyedVerts.size(); i++) verts[i] = keyedVerts[i].second;
+	m_verts.reorder(verts);
+
+	std::vector<std::pair<uint32_t, CEdge*> > keyedEdges;
+	keyedEdges.reserve(m_edges.size());
+	for (typename CElementList<CEdge>::iterator eiter = m_edges.begin(); eiter != m_edges.end(); ++eiter)
+	{
+		CPoint mid = (edgeVertex1(*eiter)->point() + edgeVertex2(*eiter)->point()) / 2.0;
+		keyedEdges.push_back(std::make_pair(order.key(mid), *eiter));
+	}
+	CMortonOrder::sort(keyedEdges);
+	std::vector<CEdge*> edges(keyedEdges.size());
+	for (size_t i = 0; i < keyedEdges.size(); i++) edges[i] = keyedEdges[i].second;
+	m_edges.reorder(edges);
+
+	std::vector<std::pair<uint32_t, CFace*> > keyedFaces;
+	keyedFaces.reserve(m_faces.size());
+	for (typename CElementList<CFace>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); ++fiter)
+	{
+		CPoint center(0, 0, 0);
+		CHalfEdge* he = faceHalfedge(*fiter);
+		CHalfEdge* he1 = he;
+		do {
+			center = center + halfedgeTarget(he1)->point();
+			he1 = halfedgeNext(he1);
+		} while (he1 != he);
+		center = center / (double)(*fiter)->degree();
+		keyedFaces.push_back(std::make_pair(order.key(center), *fiter));
+	}
+	CMortonOrder::sort(keyedFaces);
+	std::vector<CFace*> faces(keyedFaces.size());
+	for (size_t i = 0; i < keyedFaces.size(); i++) faces[i] = keyedFaces[i].second;
+	m_faces.reorder(faces);
+}
+
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+bool CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>::buildFromRecords(const CMeshRecords& r)
+{
+	bool empty = m_verts.empty() && m_faces.empty();
+	size_t nv = r.numVertices();
+	size_t nf = r.numFaces();
+	size_t nc = r.cornerVertex.size();
+
+	std::vector<CVertex*> verts(nv);
+	for (size_t i = 0; i < nv; i++)
+	{
+		verts[i] = createVertex(r.vertexId[i], r.vertexPoint[i]);
+		if (!r.vertexString[i].empty())
+		{
+			verts[i]->string().assign(r.vertexString[i].begin, r.vertexString[i].end);
+		}
+	}
+
+	//vertex of each corner, by its index in the records
+	std::vector<CVertex*> cv(nc);
+	std::vector<int> ci(nc);
+	int maxId = 0;
+	for (size_t i = 0; i < nv; i++) maxId = std::max(maxId, r.vertexId[i]);
+	bool denseIds = (size_t)maxId < 2 * nv + 1024;
+	std::vector<int> idIndex(denseIds ? maxId + 1 : 0, -1);
+	std::unordered_map<int, int> sparseIdIndex;
+	for (size_t i = 0; i < nv; i++)
+	{
+		if (denseIds && r.vertexId[i] >= 0) idIndex[r.vertexId[i]] = (int)i;
+		else sparseIdIndex[r.vertexId[i]] = (int)i;
+	}
+	for (size_t c = 0; c < nc; c++)
+	{
+		int id = r.cornerVertex[c];
+		cv[c] = idVertex(id);
+		if (cv[c] == NULL)
+		{
+			fprintf(stderr, "Face refers to the missing vertex %d\n", id);
+			return false;
+		}
+		if (denseIds && id >= 0 && id <= maxId) ci[c] = idIndex[id];
+		else {
+			std::unordered_map<int, int>::const_iterator it = sparseIdIndex.find(id);
+			ci[c] = it == sparseIdIndex.end() ? -1 : it->second;
+		}
+	}
+
+	//next corner in the face
+	std::vector<size_t> cnext(nc);
+	for (size_t f = 0; f < nf; f++)
+	{
+		for (size_t c = r.faceStart[f]; c < r.faceStart[f + 1]; c++)
+		{
+			cnext[c] = c + 1 < r.faceStart[f + 1] ? c + 1 : r.faceStart[f];
+		}
+	}
+
+	//bucket the corners by the smaller vertex of their edge, then sort each
+	//bucket by the other vertex, the corners of one edge end up side by side
+	bool valid = empty;
+	std::vector<size_t> bucket(nv + 1, 0);
+	for (size_t c = 0; c < nc && valid; c++)
+	{
+		int a = ci[c];
+		int b = ci[cnext[c]];
+		if (a < 0 || b < 0 || a == b) valid = false;
+		else bucket[std::min(a, b) + 1]++;
+	}
+	std::vector<long long> mate;
+	if (valid)
+	{
+		for (size_t i = 0; i < nv; i++) bucket[i + 1] += bucket[i];
+		std::vector<uint64_t> entries(nc);
+		std::vector<size_t> fill(bucket.begin(), bucket.end() - 1);
+		for (size_t c = 0; c < nc; c++)
+		{
+			int a = ci[c];
+			int b = ci[cnext[c]];
+			entries[fill[std::min(a, b)]++] = ((uint64_t)std::max(a, b) << 32) | (uint64_t)c;
+		}
+		assert(nc < ((uint64_t)1 << 32));
+
+		mate.assign(nc, -1);
+		int nthreads = CMeshParser::numThreads(nc, 1 << 18);
+		std::vector<char> threadValid(nthreads, 1);
+		CMeshParser::parallel(nthreads, [&](int t) {
+			size_t vb = nv * t / nthreads;
+			size_t ve = nv * (t + 1) / nthreads;
+			for (size_t v = vb; v < ve; v++)
+			{
+				std::sort(entries.begin() + bucket[v], entries.begin() + bucket[v + 1]);
+				for (size_t i = bucket[v]; i < bucket[v + 1]; )
+				{
+					size_t j = i + 1;
+					while (j < bucket[v + 1] && (entries[j] >> 32) == (entries[i] >> 32)) j++;
+					if (j - i == 2)
+					{
+						size_t c0 = (size_t)(entries[i] & 0xffffffff);
+						size_t c1 = (size_t)(entries[i + 1] & 0xffffffff);
+						//two faces of an edge must use it in opposite directions
+						if (ci[c0] == ci[c1]) threadValid[t] = 0;
+						mate[c0] = (long long)c1;
+						mate[c1] = (long long)c0;
+					}
+					else if (j - i > 2)
+					{
+						threadValid[t] = 0;
+					}
+					i = j;
+				}
+			}
+		});
+		for (int t = 0; t < nthreads; t++) valid = valid && threadValid[t];
+	}
+
+	if (!valid)
+	{
+		//non manifold or degenerate input, or a mesh which is not empty, build face by face
+		std::vector<CVertex*> v;
+		for (size_t f = 0; f < nf; f++)
+		{
+			v.assign(cv.begin() + r.faceStart[f], cv.begin() + r.faceStart[f + 1]);
+			CFace* pF = createFace(v, r.faceId[f]);
+			if (!r.faceString[f].empty()) pF->string().assign(r.faceString[f].begin, r.faceString[f].end);
+		}
+		return true;
+	}
+
+	//create the faces and the edges in the order createFace would
+	m_edge_table.reserve(m_edge_table.size() + nc);
+	std::vector<CHalfEdge*> hes(nc);
+	for (size_t f = 0; f < nf; f++)
+	{
+		int id = r.faceId[f];
+		globalFid = id < globalFid ? globalFid + 1 : id + 1;
+		if (id == -1) {
+			id = globalFid;
+		}
+		CFace* pF = m_face_pool.alloc();
+		assert(pF != NULL);
+		pF->id() = id;
+		pF->degree() = (int)(r.faceStart[f + 1] - r.faceStart[f]);
+		m_faces.push_back(pF);
+		m_map_face.insert(pF->id(), pF);
+		if (!r.faceString[f].empty()) pF->string().assign(r.faceString[f].begin, r.faceString[f].end);
+
+		for (size_t c = r.faceStart[f]; c < r.faceStart[f + 1]; c++)
+		{
+			CHalfEdge* pH;
+			if (mate[c] < 0 || (size_t)mate[c] > c)
+			{
+				//first use of the edge, see createEdge
+				tVertex v1 = cv[c];
+				tVertex v2 = cv[cnext[c]];
+				CEdge* e = m_edge_pool.alloc();
+				CHalfEdge* he1 = m_halfedge_pool.alloc();
+				CHalfEdge* he2 = m_halfedge_pool.alloc();
+				setVertex(he1, v2);
+				setVertex(he2, v1);
+				setHalfedge(v2, he1);
+				setHalfedge(v1, he2);
+				setHalfedge(e, 0, he1);
+				setHalfedge(e, 1, he2);
+				setEdge(he1, e);
+				setEdge(he2, e);
+				m_edges.push_back(e);
+				m_edge_table.insert(v1->getId(), v2->getId(), e);
+				pH = he1;
+			}
+			else
+			{
+				pH = edgeHalfedge(halfedgeEdge(hes[mate[c]]), 1);
+			}
+			setFace(pH, pF);
+			setHalfedge(pF, pH);
+			hes[c] = pH;
+			cv[c]->faceCount()++;
+			if (pF->degree() == 4) cv[c]->quadCount()++;
+		}
+
+		//linking to each other
+		for (size_t c = r.faceStart[f]; c < r.faceStart[f + 1]; c++)
+		{
+			hes[c]->he_next() = hes[cnext[c]];
+			hes[cnext[c]]->he_prev() = hes[c];
+		}
+	}
+	return true;
+}
+
 #endif //_MESHLIB_BASE_MESH_H_ defined
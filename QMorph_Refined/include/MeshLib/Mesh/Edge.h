@@ -14,6 +14,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string>
+#include "ElementList.h"
 
 namespace MeshLib{
 
@@ -66,6 +67,10 @@ public:
 		Save the traits to the string.
 	*/
 	void _to_string() {};
+	/*!
+		Links in the edge list of the mesh.
+	*/
+	CElementLink & link() { return m_link; };
 protected:
 	/*!
 		Pointers to the two halfedges attached to the current edge.
@@ -75,6 +80,10 @@ protected:
 		The string associated to the current edge.
 	*/
     std::string      m_string;
+	/*!
+		Links in the edge list of the mesh.
+	*/
+	CElementLink     m_link;
 };
 
 
@@ -0,0 +1,141 @@
+/*!
+*      \file EdgeTable.h
+*      \brief Open addressing hash table from vertex id pairs to edges
+*	   \author SirEnri
+*      \date 17/10/2026
+*
+*/
+
+#ifndef _MESHLIB_EDGE_TABLE_H_
+#define _MESHLIB_EDGE_TABLE_H_
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace MeshLib {
+
+	/*!
+	\brief CEdgeTable, edge lookup by the ids of its two end vertices
+
+	The key is the unordered pair of vertex ids. Collisions are resolved by linear
+	probing and erase shifts the following entries back, so the table never holds
+	tombstones and a lookup only visits the cluster of its slot.
+	\tparam T edge class
+	*/
+	template<typename T>
+	class CEdgeTable
+	{
+	public:
+		CEdgeTable() { m_size = 0; m_slots.resize(64); };
+
+		size_t size() const { return m_size; };
+
+		/*! the edge between the vertices with id0 and id1, NULL if there is none */
+		T* find(int id0, int id1) const {
+			uint64_t k = key(id0, id1);
+			for (size_t i = slot(k);; i = (i + 1) & mask()) {
+				const Entry& en = m_slots[i];
+				if (en.edge == NULL) return NULL;
+				if (en.key == k) return en.edge;
+			}
+		};
+
+		/*! register an edge, the pair must not be in the table yet */
+		void insert(int id0, int id1, T* e) {
+			assert(e != NULL);
+			if ((m_size + 1) * 4 > m_slots.size() * 3) {
+				rehash(m_slots.size() * 2);
+			}
+			uint64_t k = key(id0, id1);
+			size_t i = slot(k);
+			while (m_slots[i].edge != NULL) {
+				assert(m_slots[i].key != k);
+				i = (i + 1) & mask();
+			}
+			m_slots[i].key = k;
+			m_slots[i].edge = e;
+			m_size++;
+		};
+
+		/*! remove the pair from the table, return false if it was not there */
+		bool erase(int id0, int id1) {
+			uint64_t k = key(id0, id1);
+			size_t i = slot(k);
+			while (m_slots[i].key != k || m_slots[i].edge == NULL) {
+				if (m_slots[i].edge == NULL) return false;
+				i = (i + 1) & mask();
+			}
+			// shift back the entries of the cluster which would not be found any more
+			size_t j = i;
+			for (;;) {
+				m_slots[i].edge = NULL;
+				for (;;) {
+					j = (j + 1) & mask();
+					if (m_slots[j].edge == NULL) {
+						m_size--;
+						return true;
+					}
+					size_t home = slot(m_slots[j].key);
+					// move j to i unless its home lies cyclically in (i, j]
+					if (i <= j ? (i < home && home <= j) : (i < home || home <= j)) continue;
+					break;
+				}
+				m_slots[i] = m_slots[j];
+				i = j;
+			}
+		};
+
+		void clear() {
+			m_slots.assign(64, Entry());
+			m_size = 0;
+		};
+
+		/*! make room for n edges, so inserting them does not rehash */
+		void reserve(size_t n) {
+			size_t cap = m_slots.size();
+			while (n * 4 > cap * 3) cap *= 2;
+			if (cap > m_slots.size()) {
+				rehash(cap);
+			}
+		};
+
+	protected:
+		struct Entry {
+			uint64_t key = 0;
+			T* edge = NULL;
+		};
+
+		static uint64_t key(int id0, int id1) {
+			uint32_t a = (uint32_t)(id0 < id1 ? id0 : id1);
+			uint32_t b = (uint32_t)(id0 < id1 ? id1 : id0);
+			return ((uint64_t)a << 32) | b;
+		};
+		size_t mask() const { return m_slots.size() - 1; };
+		size_t slot(uint64_t k) const {
+			k ^= k >> 33;
+			k *= 0xff51afd7ed558ccdULL;
+			k ^= k >> 33;
+			return (size_t)k & mask();
+		};
+		void rehash(size_t n) {
+			std::vector<Entry> old;
+			old.swap(m_slots);
+			m_slots.resize(n);
+			for (size_t i = 0; i < old.size(); i++) {
+				if (old[i].edge == NULL) continue;
+				size_t j = slot(old[i].key);
+				while (m_slots[j].edge != NULL) {
+					j = (j + 1) & mask();
+				}
+				m_slots[j] = old[i];
+			}
+		};
+
+		std::vector<Entry> m_slots;
+		size_t m_size;
+	};
+}
+
+#endif //_MESHLIB_EDGE_TABLE_H_ defined
@@ -0,0 +1,164 @@
+/*!
+*      \file ElementList.h
+*      \brief Intrusive list holding the vertices, edges or faces of a mesh
+*
+*		Each element carries its own links, so removing an element from the
+*		list of its mesh is a constant time operation.
+*	   \author SirEnri
+*      \date 17/10/2026
+*
+*/
+
+#ifndef _MESHLIB_ELEMENT_LIST_H_
+#define _MESHLIB_ELEMENT_LIST_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include <iterator>
+#include <vector>
+
+namespace MeshLib {
+
+	/*!
+	\brief CElementLink, the previous and next element in the element list of the mesh
+	*/
+	class CElementLink
+	{
+	public:
+		CElementLink() { m_prev = NULL; m_next = NULL; };
+
+		void*& prev() { return m_prev; };
+		void*& next() { return m_next; };
+	protected:
+		void* m_prev;
+		void* m_next;
+	};
+
+	/*!
+	\brief CElementList, intrusive doubly linked list of mesh elements
+
+	The element class T must expose its CElementLink through link(). The list
+	does not own the elements, it only threads them through their links. The
+	interface follows std::list, so the mesh iterators and range based loops
+	stay the same, removing an element of the list no more searches for it.
+	\tparam T element class, derived from CVertex, CEdge or CFace
+	*/
+	template<typename T>
+	class CElementList
+	{
+	public:
+		typedef T* value_type;
+
+		/*!
+		\brief iterator of CElementList, stays valid as long as the element it points to stays in the list
+		*/
+		class iterator
+		{
+		public:
+			typedef std::forward_iterator_tag iterator_category;
+			typedef T* value_type;
+			typedef ptrdiff_t difference_type;
+			typedef T* const* pointer;
+			typedef T* const& reference;
+
+			iterator(T* e = NULL) { m_elem = e; };
+			reference operator*() const { return m_elem; };
+			iterator& operator++() { m_elem = CElementList::next(m_elem); return *this; };
+			iterator operator++(int) { iterator it = *this; m_elem = CElementList::next(m_elem); return it; };
+			bool operator==(const iterator& it) const { return m_elem == it.m_elem; };
+			bool operator!=(const iterator& it) const { return m_elem != it.m_elem; };
+		protected:
+			T* m_elem;
+		};
+
+		CElementList() { m_head = NULL; m_tail = NULL; m_size = 0; };
+		/*! the elements are owned by the mesh, the list only drops the links */
+		~CElementList() { clear(); };
+
+		iterator begin() { return iterator(m_head); };
+		iterator end() { return iterator(); };
+		size_t size() const { return m_size; };
+		bool empty() const { return m_size == 0; };
+		T* front() { return m_head; };
+		T* back() { return m_tail; };
+
+		/*! append an element which is not in any list */
+		void push_back(T* e) {
+			assert(e->link().prev() == NULL && e->link().next() == NULL && m_head != e);
+			e->link().prev() = m_tail;
+			e->link().next() = NULL;
+			if (m_tail) {
+				m_tail->link().next() = e;
+			}
+			else {
+				m_head = e;
+			}
+			m_tail = e;
+			m_size++;
+		};
+
+		/*! unlink an element of this list in constant time */
+		void remove(T* e) {
+			T* p = prev(e);
+			T* n = next(e);
+			assert(p ? next(p) == e : m_head == e);
+			assert(n ? prev(n) == e : m_tail == e);
+			if (p) {
+				p->link().next() = n;
+			}
+			else {
+				m_head = n;
+			}
+			if (n) {
+				n->link().prev() = p;
+			}
+			else {
+				m_tail = p;
+			}
+			e->link().prev() = NULL;
+			e->link().next() = NULL;
+			m_size--;
+		};
+
+		/*! unlink the element pointed by it, return the iterator to the following element */
+		iterator erase(iterator it) {
+			T* e = *it;
+			++it;
+			remove(e);
+			return it;
+		};
+
+		/*! relink the elements in the given order, which must hold every element of the list once */
+		void reorder(const std::vector<T*>& order) {
+			assert(order.size() == m_size);
+			clear();
+			for (size_t i = 0; i < order.size(); i++) {
+				push_back(order[i]);
+			}
+		};
+
+		/*! unlink all the elements, the elements themselves are not deleted */
+		void clear() {
+			T* e = m_head;
+			while (e) {
+				T* n = next(e);
+				e->link().prev() = NULL;
+				e->link().next() = NULL;
+				e = n;
+			}
+			m_head = NULL;
+			m_tail = NULL;
+			m_size = 0;
+		};
+
+	protected:
+		static T* prev(T* e) { return static_cast<T*>(e->link().prev()); };
+		static T* next(T* e) { return static_cast<T*>(e->link().next()); };
+
+		T* m_head;
+		T* m_tail;
+		size_t m_size;
+	};
+}
+
+#endif //_MESHLIB_ELEMENT_LIST_H_ defined
@@ -0,0 +1,145 @@
+/*!
+*      \file ElementPool.h
+*      \brief Free list pool allocating the elements of a mesh
+*
+*		Elements released by the Euler operators are recycled by the next
+*		creation of the same type instead of going back to the global allocator.
+*	   \author SirEnri
+*      \date 17/10/2026
+*
+*/
+
+#ifndef _MESHLIB_ELEMENT_POOL_H_
+#define _MESHLIB_ELEMENT_POOL_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include <new>
+#include <vector>
+#include <iostream>
+
+namespace MeshLib {
+
+	/*!
+	\brief CPoolStatistics, allocation counters of a CElementPool
+	*/
+	struct CPoolStatistics
+	{
+		/*! number of alloc() calls */
+		size_t allocated = 0;
+		/*! number of alloc() calls served by the free list */
+		size_t recycled = 0;
+		/*! number of release() calls */
+		size_t released = 0;
+		/*! elements alive now */
+		size_t live = 0;
+		/*! maximal number of elements alive at the same time */
+		size_t peak = 0;
+		/*! number of slots held by the pool */
+		size_t capacity = 0;
+		/*! number of blocks requested from the global allocator */
+		size_t blocks = 0;
+	};
+
+	inline std::ostream& operator<<(std::ostream& os, const CPoolStatistics& s)
+	{
+		os << "allocated " << s.allocated << " recycled " << s.recycled << " released " << s.released
+			<< " live " << s.live << " peak " << s.peak << " capacity " << s.capacity << " blocks " << s.blocks;
+		return os;
+	}
+
+	/*!
+	\brief CElementPool, type specific pool with an intrusive free list
+
+	Slots are carved from blocks whose size doubles up to a limit. A released
+	slot is destructed and put on the free list, the next alloc() constructs the
+	element in it again. The blocks are only given back when the pool is destroyed,
+	so every element must be released, or never used again, before that.
+	\tparam T element class
+	*/
+	template<typename T>
+	class CElementPool
+	{
+	public:
+		CElementPool() {
+			m_free = NULL;
+			m_next = NULL;
+			m_end = NULL;
+			m_blockSize = 64;
+		};
+		~CElementPool() {
+			for (size_t i = 0; i < m_blocks.size(); i++) {
+				::operator delete(m_blocks[i]);
+			}
+		};
+		CElementPool(const CElementPool&) = delete;
+		CElementPool& operator=(const CElementPool&) = delete;
+
+		/*! construct a new element */
+		T* alloc() {
+			Slot* s;
+			if (m_free) {
+				s = m_free;
+				m_free = s->next;
+				m_stat.recycled++;
+			}
+			else {
+				if (m_next == m_end) {
+					grow();
+				}
+				s = m_next++;
+			}
+			m_stat.allocated++;
+			m_stat.live++;
+			if (m_stat.live > m_stat.peak) {
+				m_stat.peak = m_stat.live;
+			}
+			return new (s->storage) T();
+		};
+
+		/*! destruct an element allocated by this pool and recycle its slot */
+		void release(T* e) {
+			if (e == NULL) {
+				return;
+			}
+			assert(m_stat.live > 0);
+			e->~T();
+			Slot* s = reinterpret_cast<Slot*>(e);
+			s->next = m_free;
+			m_free = s;
+			m_stat.released++;
+			m_stat.live--;
+		};
+
+		const CPoolStatistics& statistics() const { return m_stat; };
+
+	protected:
+		union Slot {
+			Slot* next;
+			alignas(T) unsigned char storage[sizeof(T)];
+		};
+
+		void grow() {
+			Slot* block = static_cast<Slot*>(::operator new(m_blockSize * sizeof(Slot)));
+			m_blocks.push_back(block);
+			m_next = block;
+			m_end = block + m_blockSize;
+			m_stat.capacity += m_blockSize;
+			m_stat.blocks++;
+			if (m_blockSize < 4096) {
+				m_blockSize *= 2;
+			}
+		};
+
+		std::vector<Slot*> m_blocks;
+		/*! head of the free list */
+		Slot* m_free;
+		/*! next untouched slot of the last block */
+		Slot* m_next;
+		Slot* m_end;
+		size_t m_blockSize;
+		CPoolStatistics m_stat;
+	};
+}
+
+#endif //_MESHLIB_ELEMENT_POOL_H_ defined
@@ -12,6 +12,7 @@
 #include <assert.h>
 #include <string>
 #include "../Geometry/Point.h"
+#include "ElementList.h"
 
 namespace MeshLib{
 
@@ -27,7 +28,7 @@ public:
 	/*!	
 	CFace constructor
 	*/
-	CFace(){ m_halfedge = NULL; };
+	CFace(){ m_halfedge = NULL; m_degree = 0; };
 	/*!
 	CFace destructor
 	*/
@@ -44,6 +45,10 @@ public:
 		The value of the current face id.
 	*/
 	const int             id() const { return m_id;      };
+	/*!
+		Number of halfedges of the current face, maintained by the mesh.
+	*/
+	int		            & degree()      { return m_degree;  };
 	/*!
 		The string of the current face.
 	*/
@@ -56,6 +61,10 @@ public:
 		read face traits from the string.
 	*/
 	void                  _from_string() {};
+	/*!
+		Links in the face list of the mesh.
+	*/
+	CElementLink		& link()        { return m_link; };
 protected:
 	/*!
 		id of the current face
@@ -65,10 +74,18 @@ protected:
 		One halfedge  attaching to the current face.
 	*/
 	CHalfEdge        * m_halfedge;
+	/*!
+		number of halfedges of the current face
+	*/
+	int                m_degree;
 	/*!
 		String of the current face.
 	*/
     std::string        m_string;
+	/*!
+		Links in the face list of the mesh.
+	*/
+	CElementLink       m_link;
 };
 
 
@@ -0,0 +1,108 @@
+/*!
+*      \file IdTable.h
+*      \brief Table from element ids to elements, dense for compact ids with a hash fallback
+*	   \author SirEnri
+*      \date 17/10/2026
+*
+*/
+
+#ifndef _MESHLIB_ID_TABLE_H_
+#define _MESHLIB_ID_TABLE_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include <vector>
+#include <unordered_map>
+
+namespace MeshLib {
+
+	/*!
+	\brief CIdTable, map between element ids and elements
+
+	Ids of our inputs are dense (1..N), they are stored in a vector indexed by id.
+	An id far beyond the ids seen so far would waste the vector, it goes to a hash
+	map instead, and moves to the vector once the vector grows over it. So an id
+	below the vector size is always found in the vector.
+	\tparam T element class
+	*/
+	template<typename T>
+	class CIdTable
+	{
+	public:
+		CIdTable() { m_size = 0; };
+
+		size_t size() const { return m_size; };
+
+		/*! the element with the id, NULL if there is none */
+		T* find(int id) const {
+			if (id >= 0 && (size_t)id < m_dense.size()) {
+				return m_dense[id];
+			}
+			if (m_sparse.empty()) {
+				return NULL;
+			}
+			typename std::unordered_map<int, T*>::const_iterator it = m_sparse.find(id);
+			return it == m_sparse.end() ? NULL : it->second;
+		};
+
+		/*! register an element, like std::map::insert an id already in the table is kept and false is returned */
+		bool insert(int id, T* e) {
+			assert(e != NULL);
+			if (find(id) != NULL) {
+				return false;
+			}
+			if (id >= 0 && (size_t)id >= m_dense.size() && (size_t)id < 2 * m_size + 1024) {
+				grow((size_t)id + 1);
+			}
+			if (id >= 0 && (size_t)id < m_dense.size()) {
+				m_dense[id] = e;
+			}
+			else {
+				m_sparse[id] = e;
+			}
+			m_size++;
+			return true;
+		};
+
+		/*! remove the id, return false if it was not there */
+		bool erase(int id) {
+			if (id >= 0 && (size_t)id < m_dense.size()) {
+				if (m_dense[id] == NULL) return false;
+				m_dense[id] = NULL;
+			}
+			else if (m_sparse.erase(id) == 0) {
+				return false;
+			}
+			m_size--;
+			return true;
+		};
+
+		void clear() {
+			m_dense.clear();
+			m_sparse.clear();
+			m_size = 0;
+		};
+
+	protected:
+		/*! enlarge the dense part geometrically and move the sparse ids it now covers */
+		void grow(size_t n) {
+			size_t cap = m_dense.size() * 2;
+			m_dense.resize(n > cap ? n : cap, NULL);
+			for (typename std::unordered_map<int, T*>::iterator it = m_sparse.begin(); it != m_sparse.end(); ) {
+				if (it->first >= 0 && (size_t)it->first < m_dense.size()) {
+					m_dense[it->first] = it->second;
+					it = m_sparse.erase(it);
+				}
+				else {
+					++it;
+				}
+			}
+		};
+
+		std::vector<T*> m_dense;
+		std::unordered_map<int, T*> m_sparse;
+		size_t m_size;
+	};
+}
+
+#endif //_MESHLIB_ID_TABLE_H_ defined
@@ -0,0 +1,132 @@
+/*!
+*      \file Property.h
+*      \brief Attributes attached to mesh elements outside of the element classes
+*
+*		Data only a few elements carry lives in a side table instead of a member
+*		of every element, so the elements stay small for the traversal.
+*	   \author SirEnri
+*      \date 17/10/2026
+*
+*/
+
+#ifndef _MESHLIB_PROPERTY_H_
+#define _MESHLIB_PROPERTY_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+namespace MeshLib {
+
+	/*!
+	\brief CPropertyBase, interface of the properties of one element type
+
+	The mesh only needs to drop the value of an element when the element is
+	deleted, the pools reuse the memory of deleted elements, so a stale value
+	would otherwise show up on a new element.
+	\tparam K element class
+	*/
+	template<typename K>
+	class CPropertyBase
+	{
+	public:
+		virtual ~CPropertyBase() {};
+		/*! forget the value of the element */
+		virtual void erase(const K* key) = 0;
+		/*! forget all values */
+		virtual void clear() = 0;
+		/*! number of elements holding a value */
+		virtual size_t size() const = 0;
+	};
+
+	/*!
+	\brief CSparseProperty, value per element stored in a hash map
+
+	Elements without an entry read the default value, only writing through
+	ref() creates an entry.
+	\tparam K element class
+	\tparam V value type
+	*/
+	template<typename K, typename V>
+	class CSparseProperty : public CPropertyBase<K>
+	{
+	public:
+		CSparseProperty(const V& defaultValue = V()) : m_default(defaultValue) {};
+
+		/*! value of the element, the default value if it has none */
+		const V& get(const K* key) const {
+			typename std::unordered_map<const K*, V>::const_iterator it = m_values.find(key);
+			return it == m_values.end() ? m_default : it->second;
+		};
+		/*! writable value of the element, created from the default value if it has none */
+		V& ref(const K* key) {
+			typename std::unordered_map<const K*, V>::iterator it = m_values.find(key);
+			if (it == m_values.end()) {
+				it = m_values.insert(std::make_pair(key, m_default)).first;
+			}
+			return it->second;
+		};
+		void set(const K* key, const V& value) { ref(key) = value; };
+		bool has(const K* key) const { return m_values.find(key) != m_values.end(); };
+		/*! value of the element, NULL if it has none */
+		const V* find(const K* key) const {
+			typename std::unordered_map<const K*, V>::const_iterator it = m_values.find(key);
+			return it == m_values.end() ? NULL : &it->second;
+		};
+		const V& defaultValue() const { return m_default; };
+		/*! make room for n values without rehashing */
+		void reserve(size_t n) { m_values.reserve(n); };
+
+		typedef typename std::unordered_map<const K*, V>::const_iterator const_iterator;
+		/*! the elements holding a value, in no particular order */
+		const_iterator begin() const { return m_values.begin(); };
+		const_iterator end() const { return m_values.end(); };
+
+		virtual void erase(const K* key) { m_values.erase(key); };
+		virtual void clear() { m_values.clear(); };
+		virtual size_t size() const { return m_values.size(); };
+
+	protected:
+		std::unordered_map<const K*, V> m_values;
+		V m_default;
+	};
+
+	/*!
+	\brief CPropertyRegistry, properties of one element type registered on a mesh
+
+	The registry does not own the properties, a property must be removed before
+	it is destroyed if the mesh lives longer.
+	\tparam K element class
+	*/
+	template<typename K>
+	class CPropertyRegistry
+	{
+	public:
+		void add(CPropertyBase<K>* p) {
+			assert(p != NULL);
+			assert(std::find(m_properties.begin(), m_properties.end(), p) == m_properties.end());
+			m_properties.push_back(p);
+		};
+		void remove(CPropertyBase<K>* p) {
+			m_properties.erase(std::remove(m_properties.begin(), m_properties.end(), p), m_properties.end());
+		};
+		/*! called by the mesh when the element is deleted */
+		void erase(const K* key) {
+			for (size_t i = 0; i < m_properties.size(); i++) {
+				m_properties[i]->erase(key);
+			}
+		};
+		void clear() {
+			for (size_t i = 0; i < m_properties.size(); i++) {
+				m_properties[i]->clear();
+			}
+		};
+
+	protected:
+		std::vector<CPropertyBase<K>*> m_properties;
+	};
+}
+
+#endif //_MESHLIB_PROPERTY_H_ defined
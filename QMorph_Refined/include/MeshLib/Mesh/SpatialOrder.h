@@ -0,0 +1,82 @@
+/*!
+*      \file SpatialOrder.h
+*      \brief Morton order of planar points, used to sort the elements of a mesh
+*	   \author SirEnri
+*      \date 17/10/2026
+*
+*/
+
+#ifndef _MESHLIB_SPATIAL_ORDER_H_
+#define _MESHLIB_SPATIAL_ORDER_H_
+
+#include <stdint.h>
+#include <float.h>
+#include <utility>
+#include <vector>
+#include <algorithm>
+#include "../Geometry/Point.h"
+
+namespace MeshLib {
+
+	/*!
+	\brief CMortonOrder, Z-order curve key of the x, y coordinates of a point
+
+	The coordinates are quantized to 16 bits inside the bounding box given by
+	the added points, the key interleaves the bits of x and y. Points close in
+	the key are close in the plane, except across the jumps of the curve.
+	*/
+	class CMortonOrder
+	{
+	public:
+		CMortonOrder() {
+			m_min[0] = m_min[1] = DBL_MAX;
+			m_max[0] = m_max[1] = -DBL_MAX;
+		};
+
+		/*! enlarge the bounding box to contain p */
+		void add(const CPoint& p) {
+			for (int i = 0; i < 2; i++) {
+				if (p[i] < m_min[i]) m_min[i] = p[i];
+				if (p[i] > m_max[i]) m_max[i] = p[i];
+			}
+		};
+
+		/*! key of p, p must lie in the bounding box */
+		uint32_t key(const CPoint& p) const {
+			return interleave(quantize(p[0], 0)) | (interleave(quantize(p[1], 1)) << 1);
+		};
+
+		/*! sort the elements by the keys of their points, equal keys keep their order */
+		template<typename T>
+		static void sort(std::vector<std::pair<uint32_t, T*> >& keyed) {
+			std::stable_sort(keyed.begin(), keyed.end(),
+				[](const std::pair<uint32_t, T*>& a, const std::pair<uint32_t, T*>& b) { return a.first < b.first; });
+		};
+
+	protected:
+		uint32_t quantize(double x, int axis) const {
+			double extent = m_max[axis] - m_min[axis];
+			if (!(extent > 0)) {
+				return 0;
+			}
+			double t = (x - m_min[axis]) / extent;
+			if (t < 0) t = 0;
+			if (t > 1) t = 1;
+			return (uint32_t)(t * 65535.0);
+		};
+		/*! spread the 16 low bits of x to the even bits */
+		static uint32_t interleave(uint32_t x) {
+			x &= 0x0000ffff;
+			x = (x | (x << 8)) & 0x00ff00ff;
+			x = (x | (x << 4)) & 0x0f0f0f0f;
+			x = (x | (x << 2)) & 0x33333333;
+			x = (x | (x << 1)) & 0x55555555;
+			return x;
+		};
+
+		double m_min[2];
+		double m_max[2];
+	};
+}
+
+#endif //_MESHLIB_SPATIAL_ORDER_H_ defined
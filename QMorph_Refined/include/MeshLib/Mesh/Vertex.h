@@ -15,11 +15,22 @@
 #include "../Geometry/Point.h"
 #include "../Geometry/Point2.h"
 #include "HalfEdge.h"
+#include "ElementList.h"
 
 namespace MeshLib{
 
   class CHalfEdge;
 
+  /*!
+  \brief CVertexAttributes, attributes of a vertex which only some inputs carry
+  */
+  struct CVertexAttributes
+  {
+	  CPoint normal;
+	  CPoint2 uv;
+	  std::string string;
+  };
+
   /*!
   \brief CVertex class, which is the base class of all kinds of vertex classes
   */
@@ -33,30 +44,42 @@ namespace MeshLib{
       CVertex(){
 		  m_halfedge = NULL; 
 		  m_id = -1;
+		  m_faceCount = 0;
+		  m_quadCount = 0;
+		  m_attributes = NULL;
+		  m_attributeFlags = 0;
 	  };
 	  /*!
 	  CVertex destructor 
 	  */
-    ~CVertex(){};
+    ~CVertex(){ delete m_attributes; };
+	CVertex(const CVertex&) = delete;
+	CVertex& operator=(const CVertex&) = delete;
 
 	/*! The point of the vertex
 	*/
     CPoint & point()    { return m_point;};
-	/*! The normal of the vertex
+	/*! The normal of the vertex, allocated on the first call
 	*/
-    CPoint & normal()   { return m_normal; };
-	/*! The texutre coordinates of the vertex
+    CPoint & normal()   { return attributes(NORMAL).normal; };
+	/*! The texutre coordinates of the vertex, allocated on the first call
 	*/
-	CPoint2 & uv()       { return m_uv; };
+	CPoint2 & uv()       { return attributes(UV).uv; };
+	/*! Whether normal(), uv() or string() has been requested, reading the
+	    attribute of a vertex without it gives the default value
+	*/
+	bool hasNormal() const { return (m_attributeFlags & NORMAL) != 0; };
+	bool hasUV() const { return (m_attributeFlags & UV) != 0; };
+	bool hasString() const { return (m_attributeFlags & STRING) != 0; };
 
 	/*! One incoming halfedge of the vertex .
 	*/
     CHalfEdge * & halfedge() {
 		return m_halfedge; 
 	};
-	/*! the string of the vertex. 
+	/*! the string of the vertex, allocated on the first call
 	*/
-	std::string & string() { return m_string;};
+	std::string & string() { return attributes(STRING).string;};
 	/*! Vertex id. 
 	*/
   protected:
@@ -76,11 +99,27 @@ namespace MeshLib{
 	*/
 	void _from_string() {};
 
-	/*!	Adjacent edges, temporarily used for loading the mesh
+	/*!	Number of incident face corners, maintained by createFace and deleteFace
+	 */
+	int & faceCount() { return m_faceCount; };
+	/*!	Number of incident quad corners, maintained by createFace and deleteFace
+	 */
+	int & quadCount() { return m_quadCount; };
+
+	/*!	Links in the vertex list of the mesh
 	 */
-	std::list<CEdge*> & edges() { return m_edges; };
+	CElementLink & link() { return m_link; };
 
   protected:
+	enum { NORMAL = 1, UV = 2, STRING = 4 };
+
+	CVertexAttributes & attributes(int flag) {
+		if (m_attributes == NULL) {
+			m_attributes = new CVertexAttributes();
+		}
+		m_attributeFlags |= flag;
+		return *m_attributes;
+	};
 
     /*! Vertex ID. 
 	*/
@@ -88,24 +127,25 @@ namespace MeshLib{
     /*! Vertex position point. 
 	*/
     CPoint m_point;
-	/*! Normal at the vertex. 
-	*/
-    CPoint m_normal;
-	/*! Texture coordinates of the vertex. 
-	*/
-	CPoint2 m_uv;
 	
 	// in boundary halfedge if vertex is on boundary
     CHalfEdge *     m_halfedge;
-	/*! Indicating if the vertex is on the boundary. 
+	/*! Normal, texture coordinates and the string which stores the traits
+	    information, NULL until one of them is requested
 	*/
-	/*! The string of the vertex, which stores the traits information. 
+	CVertexAttributes * m_attributes;
+	/*! Which of the attributes have been requested
 	*/
-	std::string     m_string;
+	int m_attributeFlags;
+
+	/*! Incident face corners, incident quad corners
+	 */
+	int m_faceCount;
+	int m_quadCount;
 
-	/*! List of adjacent edges, such that current vertex is the end vertex of the edge with smaller id
+	/*! Links in the vertex list of the mesh
 	 */
-	std::list<CEdge*> m_edges;
+	CElementLink m_link;
 
   }; //class CVertex
 
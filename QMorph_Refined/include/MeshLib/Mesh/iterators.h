@@ -580,7 +580,7 @@ namespace MeshLib {
 		/*!
 		Current vertex list iterator.
 		*/
-		typename std::list<CVertex*>::iterator m_iter;
+		typename CElementList<CVertex>::iterator m_iter;
 	};
 
 	// mesh->f
@@ -628,7 +628,7 @@ namespace MeshLib {
 		CBaseMesh<CVertex, CEdge, CFace, CHalfEdge>* m_pMesh;
 		/*! Current face list iterator.
 		*/
-		typename std::list<CFace*>::iterator  m_iter;
+		typename CElementList<CFace>::iterator  m_iter;
 	};
 
 	//Mesh->e
@@ -678,7 +678,7 @@ namespace MeshLib {
 		/*!
 		current edge list iterator
 		*/
-		typename std::list<CEdge*>::iterator m_iter;
+		typename CElementList<CEdge>::iterator m_iter;
 	};
 
 	// Mesh->he
@@ -775,7 +775,7 @@ namespace MeshLib {
 		/*!
 			Current edge list iterator
 		*/
-		typename std::list<CEdge*>::iterator m_iter;
+		typename CElementList<CEdge>::iterator m_iter;
 		int  m_id;
 	};
 
@@ -0,0 +1,138 @@
+/*!
+*      \file BufferedWriter.h
+*      \brief Text output through a reusable buffer, flushed in chunks to a file or a sink
+*	   \author SirEnri
+*      \date 17/10/2026
+*
+*/
+
+#ifndef _MESHLIB_BUFFERED_WRITER_H_
+#define _MESHLIB_BUFFERED_WRITER_H_
+
+#include <stdio.h>
+#include <string.h>
+#include <charconv>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace MeshLib {
+
+	/*!
+	\brief CBufferedWriter, formats numbers with to_chars into a buffer of fixed size
+
+	The buffer is handed to the output whenever it is full, so the size of the
+	written file does not matter. A double is written like an ostream with the
+	default flags writes it, %g with 6 significant digits.
+	*/
+	class CBufferedWriter
+	{
+	public:
+		/*! receives each chunk of the output */
+		typedef std::function<void(const char*, size_t)> Sink;
+
+		CBufferedWriter(size_t capacity = 1 << 20) : m_file(NULL), m_fail(false) {
+			m_buffer.resize(capacity < 64 ? 64 : capacity);
+			m_pos = 0;
+		};
+		~CBufferedWriter() { close(); };
+		CBufferedWriter(const CBufferedWriter&) = delete;
+		CBufferedWriter& operator=(const CBufferedWriter&) = delete;
+
+		/*! write to a file, text mode translates the line ends like an fstream does */
+		bool open(const char* filename, bool binary = false) {
+			close();
+			m_file = fopen(filename, binary ? "wb" : "w");
+			m_fail = m_file == NULL;
+			return !m_fail;
+		};
+		/*! write to a callback instead of a file */
+		void open(const Sink& sink) {
+			close();
+			m_sink = sink;
+			m_fail = false;
+		};
+		/*! flush and release the output, false if anything failed to write */
+		bool close() {
+			flush();
+			if (m_file && fclose(m_file) != 0) {
+				m_fail = true;
+			}
+			m_file = NULL;
+			m_sink = Sink();
+			return !m_fail;
+		};
+		void flush() {
+			if (m_pos == 0) {
+				return;
+			}
+			if (m_file) {
+				if (fwrite(m_buffer.data(), 1, m_pos, m_file) != m_pos) m_fail = true;
+			}
+			else if (m_sink) {
+				m_sink(m_buffer.data(), m_pos);
+			}
+			m_pos = 0;
+		};
+		bool fail() const { return m_fail; };
+
+		CBufferedWriter& write(const char* data, size_t size) {
+			if (m_pos + size > m_buffer.size()) {
+				flush();
+				if (size > m_buffer.size()) {
+					//too large for the buffer, hand it over as is
+					if (m_file) {
+						if (fwrite(data, 1, size, m_file) != size) m_fail = true;
+					}
+					else if (m_sink) {
+						m_sink(data, size);
+					}
+					return *this;
+				}
+			}
+			memcpy(m_buffer.data() + m_pos, data, size);
+			m_pos += size;
+			return *this;
+		};
+		CBufferedWriter& write(const std::string& s) { return write(s.data(), s.size()); };
+		CBufferedWriter& write(const char* s) { return write(s, strlen(s)); };
+		CBufferedWriter& put(char c) {
+			if (m_pos == m_buffer.size()) flush();
+			m_buffer[m_pos++] = c;
+			return *this;
+		};
+
+		/*! integers in decimal */
+		template<typename T> CBufferedWriter& writeInt(T value) {
+			reserve(32);
+			m_pos = std::to_chars(m_buffer.data() + m_pos, m_buffer.data() + m_buffer.size(), value).ptr - m_buffer.data();
+			return *this;
+		};
+		CBufferedWriter& writeDouble(double value) {
+			reserve(32);
+			m_pos = std::to_chars(m_buffer.data() + m_pos, m_buffer.data() + m_buffer.size(), value, std::chars_format::general, 6).ptr - m_buffer.data();
+			return *this;
+		};
+
+		CBufferedWriter& operator<<(const char* s) { return write(s); };
+		CBufferedWriter& operator<<(const std::string& s) { return write(s); };
+		CBufferedWriter& operator<<(char c) { return put(c); };
+		CBufferedWriter& operator<<(int value) { return writeInt(value); };
+		CBufferedWriter& operator<<(size_t value) { return writeInt(value); };
+		CBufferedWriter& operator<<(double value) { return writeDouble(value); };
+
+	protected:
+		/*! make room for n characters */
+		void reserve(size_t n) {
+			if (m_pos + n > m_buffer.size()) flush();
+		};
+
+		std::vector<char> m_buffer;
+		size_t m_pos;
+		FILE* m_file;
+		Sink m_sink;
+		bool m_fail;
+	};
+}
+
+#endif //_MESHLIB_BUFFERED_WRITER_H_ defined
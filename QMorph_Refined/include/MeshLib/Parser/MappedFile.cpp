@@ -0,0 +1,91 @@
+/*!
+*      \file MappedFile.cpp
+*      \brief System calls of CMappedFile
+*	   \author SirEnri
+*      \date 17/10/2026
+*
+*/
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace MeshLib {
+
+	bool CMappedFile::open(const char* filename) {
+		close();
+#ifdef _WIN32
+		HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+		m_file = (intptr_t)file;
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size)) {
+			close();
+			return false;
+		}
+		m_size = (size_t)size.QuadPart;
+		if (m_size == 0) {
+			return true;
+		}
+		m_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (m_mapping == NULL) {
+			close();
+			return false;
+		}
+		m_data = (const char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+		if (m_data == NULL) {
+			close();
+			return false;
+		}
+#else
+		m_file = ::open(filename, O_RDONLY);
+		if (m_file < 0) {
+			return false;
+		}
+		struct stat st;
+		if (fstat((int)m_file, &st) != 0) {
+			close();
+			return false;
+		}
+		m_size = (size_t)st.st_size;
+		if (m_size == 0) {
+			return true;
+		}
+		void* p = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, (int)m_file, 0);
+		if (p == MAP_FAILED) {
+			close();
+			return false;
+		}
+		m_data = (const char*)p;
+		posix_madvise(p, m_size, POSIX_MADV_SEQUENTIAL);
+#endif
+		return true;
+	}
+
+	void CMappedFile::close() {
+#ifdef _WIN32
+		if (m_data) UnmapViewOfFile(m_data);
+		if (m_mapping) CloseHandle(m_mapping);
+		if (m_file != -1) CloseHandle((HANDLE)m_file);
+#else
+		if (m_data) munmap((void*)m_data, m_size);
+		if (m_file >= 0) ::close((int)m_file);
+#endif
+		init();
+	}
+}
@@ -0,0 +1,58 @@
+/*!
+*      \file MappedFile.h
+*      \brief Read only memory mapping of a whole file
+*	   \author SirEnri
+*      \date 17/10/2026
+*
+*/
+
+#ifndef _MESHLIB_MAPPED_FILE_H_
+#define _MESHLIB_MAPPED_FILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace MeshLib {
+
+	/*!
+	\brief CMappedFile, the content of a file mapped read only into memory
+
+	The pages are loaded by the system on the first access, the file is read
+	without a copy into a user buffer. An empty file opens with size() 0.
+	The system calls are in MappedFile.cpp, so the header does not pull the
+	platform headers into every file including BaseMesh.h.
+	*/
+	class CMappedFile
+	{
+	public:
+		CMappedFile() { init(); };
+		~CMappedFile() { close(); };
+		CMappedFile(const CMappedFile&) = delete;
+		CMappedFile& operator=(const CMappedFile&) = delete;
+
+		/*! map the file, return false if it cannot be opened */
+		bool open(const char* filename);
+
+		void close();
+
+		const char* data() const { return m_data; };
+		size_t size() const { return m_size; };
+
+	protected:
+		void init() {
+			m_data = NULL;
+			m_size = 0;
+			m_file = -1;
+			m_mapping = NULL;
+		};
+
+		const char* m_data;
+		size_t m_size;
+		/*! the file descriptor, or the file HANDLE on Windows, -1 when closed */
+		intptr_t m_file;
+		/*! the HANDLE of the mapping on Windows */
+		void* m_mapping;
+	};
+}
+
+#endif //_MESHLIB_MAPPED_FILE_H_ defined
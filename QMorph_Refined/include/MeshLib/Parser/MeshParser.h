@@ -0,0 +1,465 @@
+/*!
+*      \file MeshParser.h
+*      \brief Parallel parsers of .m, .obj and .off files into flat record arrays
+*
+*		The mapped file is cut into chunks at line starts, each chunk is parsed
+*		by its own thread and the records are joined in file order. Building the
+*		mesh from the records is left to CBaseMesh::buildFromRecords.
+*	   \author SirEnri
+*      \date 17/10/2026
+*
+*/
+
+#ifndef _MESHLIB_MESH_PARSER_H_
+#define _MESHLIB_MESH_PARSER_H_
+
+#include <assert.h>
+#include <string.h>
+#include <stddef.h>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include "../Geometry/Point.h"
+#include "../Geometry/Point2.h"
+#include "SpanTokenizer.h"
+#include "MappedFile.h"
+
+namespace MeshLib {
+
+	/*!
+	\brief CTextRange, characters inside the mapped file, a NULL begin means no text
+	*/
+	struct CTextRange
+	{
+		const char* begin = NULL;
+		const char* end = NULL;
+
+		CTextRange() {};
+		CTextRange(const char* b, const char* e) : begin(b), end(e) {};
+		bool empty() const { return begin == NULL; };
+	};
+
+	/*!
+	\brief CMeshRecords, the elements of a mesh file in flat arrays
+
+	Vertices and faces keep the order of the file. Corners and the edge and
+	corner traits refer to vertices and faces by their ids. The text ranges
+	point into the mapped file, which must stay open until the mesh is built.
+	*/
+	struct CMeshRecords
+	{
+		std::vector<int> vertexId;
+		std::vector<CPoint> vertexPoint;
+		std::vector<CTextRange> vertexString;
+
+		/*! face id, -1 lets the mesh number the face */
+		std::vector<int> faceId;
+		/*! first corner of each face, with one more entry closing the last face */
+		std::vector<size_t> faceStart;
+		std::vector<CTextRange> faceString;
+		/*! vertex id of each face corner */
+		std::vector<int> cornerVertex;
+
+		/*! texture coordinates and normals of an .obj file */
+		std::vector<CPoint2> uvs;
+		std::vector<CPoint> normals;
+		/*! index in uvs and normals of each corner, -1 for none */
+		std::vector<int> cornerUV;
+		std::vector<int> cornerNormal;
+		/*! number of uvs and normals read before each face, the face may only use those */
+		std::vector<int> faceUVCount;
+		std::vector<int> faceNormalCount;
+
+		/*! traits of the Edge lines, two vertex ids per edge */
+		std::vector<int> edgeVertex;
+		std::vector<CTextRange> edgeString;
+		/*! traits of the Corner lines */
+		std::vector<int> traitCornerVertex;
+		std::vector<int> traitCornerFace;
+		std::vector<CTextRange> traitCornerString;
+
+		CMeshRecords() { faceStart.push_back(0); };
+
+		size_t numVertices() const { return vertexId.size(); };
+		size_t numFaces() const { return faceId.size(); };
+
+		/*! close a face whose corners have been pushed */
+		void endFace(int id, const CTextRange& str) {
+			faceId.push_back(id);
+			faceString.push_back(str);
+			faceStart.push_back(cornerVertex.size());
+		};
+
+		/*! add the records of the chunk following this one */
+		void append(const CMeshRecords& r) {
+			size_t corners = cornerVertex.size();
+			int nuv = (int)uvs.size();
+			int nnormal = (int)normals.size();
+			vertexId.insert(vertexId.end(), r.vertexId.begin(), r.vertexId.end());
+			vertexPoint.insert(vertexPoint.end(), r.vertexPoint.begin(), r.vertexPoint.end());
+			vertexString.insert(vertexString.end(), r.vertexString.begin(), r.vertexString.end());
+			faceId.insert(faceId.end(), r.faceId.begin(), r.faceId.end());
+			for (size_t i = 1; i < r.faceStart.size(); i++) {
+				faceStart.push_back(r.faceStart[i] + corners);
+			}
+			faceString.insert(faceString.end(), r.faceString.begin(), r.faceString.end());
+			cornerVertex.insert(cornerVertex.end(), r.cornerVertex.begin(), r.cornerVertex.end());
+			uvs.insert(uvs.end(), r.uvs.begin(), r.uvs.end());
+			normals.insert(normals.end(), r.normals.begin(), r.normals.end());
+			cornerUV.insert(cornerUV.end(), r.cornerUV.begin(), r.cornerUV.end());
+			cornerNormal.insert(cornerNormal.end(), r.cornerNormal.begin(), r.cornerNormal.end());
+			for (size_t i = 0; i < r.faceUVCount.size(); i++) {
+				faceUVCount.push_back(r.faceUVCount[i] + nuv);
+				faceNormalCount.push_back(r.faceNormalCount[i] + nnormal);
+			}
+			edgeVertex.insert(edgeVertex.end(), r.edgeVertex.begin(), r.edgeVertex.end());
+			edgeString.insert(edgeString.end(), r.edgeString.begin(), r.edgeString.end());
+			traitCornerVertex.insert(traitCornerVertex.end(), r.traitCornerVertex.begin(), r.traitCornerVertex.end());
+			traitCornerFace.insert(traitCornerFace.end(), r.traitCornerFace.begin(), r.traitCornerFace.end());
+			traitCornerString.insert(traitCornerString.end(), r.traitCornerString.begin(), r.traitCornerString.end());
+		};
+	};
+
+	/*!
+	\brief CMeshParser, parse a mapped mesh file into CMeshRecords
+
+	The lines are split and the numbers read with the same rules as the stream
+	readers had, so the records give the same mesh.
+	*/
+	class CMeshParser
+	{
+	public:
+		/*! number of threads used for n work items of the given size in bytes */
+		static int numThreads(size_t bytes, size_t minChunk = (1 << 20)) {
+			size_t n = std::thread::hardware_concurrency();
+			if (n == 0) n = 1;
+			size_t m = bytes / minChunk;
+			if (m < n) n = m;
+			return n < 1 ? 1 : (int)n;
+		};
+
+		/*! run fn(i) for i in [0, n) on n threads, the calling thread takes i = 0 */
+		template<typename F>
+		static void parallel(int n, F fn) {
+			std::vector<std::thread> threads;
+			for (int i = 1; i < n; i++) {
+				threads.push_back(std::thread(fn, i));
+			}
+			fn(0);
+			for (size_t i = 0; i < threads.size(); i++) {
+				threads[i].join();
+			}
+		};
+
+		static void parse_m(const CMappedFile& file, CMeshRecords& records) {
+			const char* b = file.data();
+			const char* e = b + file.size();
+			parseChunks(b, e, records, [](const char* cb, const char* ce, CMeshRecords& r) { parse_m_chunk(cb, ce, r); });
+		};
+
+		static void parse_obj(const CMappedFile& file, CMeshRecords& records) {
+			const char* b = file.data();
+			const char* e = b + file.size();
+			parseChunks(b, e, records, [](const char* cb, const char* ce, CMeshRecords& r) { parse_obj_chunk(cb, ce, r); });
+			// the vertices of an .obj file are numbered by their order
+			for (size_t i = 0; i < records.vertexId.size(); i++) {
+				records.vertexId[i] = (int)i + 1;
+			}
+		};
+
+		static void parse_off(const CMappedFile& file, CMeshRecords& records) {
+			const char* cur = file.data();
+			const char* end = cur + file.size();
+
+			//read in the first line "OFF"
+			const char* lb;
+			const char* le;
+			while (nextLine(cur, end, lb, le)) {
+				strutil::SpanTokenizer stokenizer(lb, le, " \r\n");
+				stokenizer.nextToken();
+				if (stokenizer.tokenEquals("OFF") || stokenizer.tokenEquals("NOFF")) break;
+			}
+
+			//read in Vertex Number, Face Number, Edge Number
+			int nVertices = 0;
+			int nFaces = 0;
+			if (nextLine(cur, end, lb, le)) {
+				strutil::SpanTokenizer stokenizer(lb, le, " \r\n");
+				stokenizer.nextToken();
+				nVertices = strutil::parseChars<int>(stokenizer.tokenBegin(), stokenizer.tokenEnd());
+				stokenizer.nextToken();
+				nFaces = strutil::parseChars<int>(stokenizer.tokenBegin(), stokenizer.tokenEnd());
+			}
+
+			// the kind of a line depends on its number, count the lines of each chunk first
+			std::vector<CTextRange> chunks = split(cur, end, numThreads(end - cur));
+			std::vector<size_t> firstLine(chunks.size() + 1, 0);
+			parallel((int)chunks.size(), [&](int i) {
+				firstLine[i + 1] = std::count(chunks[i].begin, chunks[i].end, '\n');
+			});
+			for (size_t i = 0; i < chunks.size(); i++) {
+				firstLine[i + 1] += firstLine[i];
+			}
+			std::vector<CMeshRecords> parts(chunks.size());
+			parallel((int)chunks.size(), [&](int i) {
+				parse_off_chunk(chunks[i].begin, chunks[i].end, firstLine[i], nVertices, nFaces, parts[i]);
+			});
+			for (size_t i = 0; i < parts.size(); i++) {
+				records.append(parts[i]);
+			}
+		};
+
+	protected:
+		/*! the next line of [cur, end) without its line break, false at the end */
+		static bool nextLine(const char*& cur, const char* end, const char*& lb, const char*& le) {
+			if (cur >= end) {
+				return false;
+			}
+			lb = cur;
+			le = (const char*)memchr(cur, '\n', end - cur);
+			if (le == NULL) le = end;
+			cur = le < end ? le + 1 : end;
+			return true;
+		};
+
+		static void trim(const char*& lb, const char*& le) {
+			while (lb < le && (*lb == ' ' || *lb == '\t' || *lb == '\r')) lb++;
+			while (le > lb && (le[-1] == ' ' || le[-1] == '\t' || le[-1] == '\r')) le--;
+		};
+
+		/*! cut [b, e) into n chunks starting at line starts */
+		static std::vector<CTextRange> split(const char* b, const char* e, int n) {
+			std::vector<CTextRange> chunks;
+			const char* start = b;
+			for (int i = 1; i <= n && start < e; i++) {
+				const char* stop = i == n ? e : b + (e - b) * i / n;
+				if (stop < start) stop = start;
+				if (stop < e) {
+					const char* nl = (const char*)memchr(stop, '\n', e - stop);
+					stop = nl == NULL ? e : nl + 1;
+				}
+				chunks.push_back(CTextRange(start, stop));
+				start = stop;
+			}
+			if (chunks.empty()) {
+				chunks.push_back(CTextRange(b, e));
+			}
+			return chunks;
+		};
+
+		template<typename F>
+		static void parseChunks(const char* b, const char* e, CMeshRecords& records, F parse) {
+			std::vector<CTextRange> chunks = split(b, e, numThreads(e - b));
+			if (chunks.size() == 1) {
+				parse(b, e, records);
+				return;
+			}
+			std::vector<CMeshRecords> parts(chunks.size());
+			parallel((int)chunks.size(), [&](int i) {
+				parse(chunks[i].begin, chunks[i].end, parts[i]);
+			});
+			for (size_t i = 0; i < parts.size(); i++) {
+				records.append(parts[i]);
+			}
+		};
+
+		static CTextRange bracedText(const strutil::SpanTokenizer& stokenizer) {
+			const char* sp;
+			const char* ep;
+			if (stokenizer.findBracedText(sp, ep)) {
+				return CTextRange(sp, ep);
+			}
+			return CTextRange();
+		};
+
+		static int parseInt(const strutil::SpanTokenizer& stokenizer) {
+			return strutil::parseChars<int>(stokenizer.tokenBegin(), stokenizer.tokenEnd());
+		};
+		static float parseFloat(const strutil::SpanTokenizer& stokenizer) {
+			return strutil::parseChars<float>(stokenizer.tokenBegin(), stokenizer.tokenEnd());
+		};
+
+		static void parse_m_chunk(const char* cur, const char* end, CMeshRecords& r) {
+			const char* lb;
+			const char* le;
+			while (nextLine(cur, end, lb, le))
+			{
+				trim(lb, le);
+				strutil::SpanTokenizer stokenizer(lb, le, " \r\n");
+				stokenizer.nextToken();
+
+				if (stokenizer.tokenEquals("Vertex"))
+				{
+					stokenizer.nextToken();
+					r.vertexId.push_back(parseInt(stokenizer));
+					CPoint p;
+					for (int i = 0; i < 3; i++)
+					{
+						stokenizer.nextToken();
+						p[i] = parseFloat(stokenizer);
+					}
+					r.vertexPoint.push_back(p);
+					r.vertexString.push_back(stokenizer.nextToken("\t\r\n") ? bracedText(stokenizer) : CTextRange());
+					continue;
+				}
+
+				if (stokenizer.tokenEquals("Face"))
+				{
+					stokenizer.nextToken();
+					int id = parseInt(stokenizer);
+					CTextRange str;
+					while (stokenizer.nextToken())
+					{
+						if (stokenizer.tokenStartsWith('{'))
+						{
+							const char* b = stokenizer.tokenBegin();
+							const char* e = stokenizer.tokenEnd();
+							while (b < e && (*b == '{' || *b == '}')) b++;
+							while (e > b && (e[-1] == '{' || e[-1] == '}')) e--;
+							str = CTextRange(b, e);
+							break;
+						}
+						r.cornerVertex.push_back(parseInt(stokenizer));
+					}
+					r.endFace(id, str);
+					continue;
+				}
+
+				//read in edge attributes
+				if (stokenizer.tokenEquals("Edge"))
+				{
+					stokenizer.nextToken();
+					int id0 = parseInt(stokenizer);
+					stokenizer.nextToken();
+					int id1 = parseInt(stokenizer);
+					if (!stokenizer.nextToken("\t\r\n")) continue;
+					CTextRange str = bracedText(stokenizer);
+					if (str.empty()) continue;
+					r.edgeVertex.push_back(id0);
+					r.edgeVertex.push_back(id1);
+					r.edgeString.push_back(str);
+					continue;
+				}
+
+				//read in corner attributes
+				if (stokenizer.tokenEquals("Corner"))
+				{
+					stokenizer.nextToken();
+					int vid = parseInt(stokenizer);
+					stokenizer.nextToken();
+					int fid = parseInt(stokenizer);
+					if (!stokenizer.nextToken("\t\r\n")) continue;
+					CTextRange str = bracedText(stokenizer);
+					if (str.empty()) continue;
+					r.traitCornerVertex.push_back(vid);
+					r.traitCornerFace.push_back(fid);
+					r.traitCornerString.push_back(str);
+					continue;
+				}
+			}
+		};
+
+		static void parse_obj_chunk(const char* cur, const char* end, CMeshRecords& r) {
+			const char* lb;
+			const char* le;
+			while (nextLine(cur, end, lb, le))
+			{
+				trim(lb, le);
+				strutil::SpanTokenizer stokenizer(lb, le, " \t\r\n");
+				stokenizer.nextToken();
+
+				if (stokenizer.tokenEquals("v"))
+				{
+					CPoint p;
+					for (int i = 0; i < 3; i++)
+					{
+						stokenizer.nextToken();
+						p[i] = parseFloat(stokenizer);
+					}
+					r.vertexId.push_back(0);
+					r.vertexPoint.push_back(p);
+					r.vertexString.push_back(CTextRange());
+					continue;
+				}
+
+				if (stokenizer.tokenEquals("vt"))
+				{
+					CPoint2 uv;
+					for (int i = 0; i < 2; i++)
+					{
+						stokenizer.nextToken();
+						uv[i] = parseFloat(stokenizer);
+					}
+					r.uvs.push_back(uv);
+					continue;
+				}
+
+				if (stokenizer.tokenEquals("vn"))
+				{
+					CPoint n;
+					for (int i = 0; i < 3; i++)
+					{
+						stokenizer.nextToken();
+						n[i] = parseFloat(stokenizer);
+					}
+					r.normals.push_back(n);
+					continue;
+				}
+
+				if (stokenizer.tokenEquals("f"))
+				{
+					for (int i = 0; i < 3; i++)
+					{
+						stokenizer.nextToken();
+						strutil::SpanTokenizer tokenizer(stokenizer.tokenBegin(), stokenizer.tokenEnd(), " /\t\r\n");
+						int ids[3] = { 0, 0, 0 };
+						for (int k = 0; k < 3 && tokenizer.nextToken(); k++)
+						{
+							ids[k] = parseInt(tokenizer);
+						}
+						r.cornerVertex.push_back(ids[0]);
+						r.cornerUV.push_back(ids[1] - 1);
+						r.cornerNormal.push_back(ids[2] - 1);
+					}
+					r.faceUVCount.push_back((int)r.uvs.size());
+					r.faceNormalCount.push_back((int)r.normals.size());
+					r.endFace(-1, CTextRange());
+				}
+			}
+		};
+
+		static void parse_off_chunk(const char* cur, const char* end, size_t line, int nVertices, int nFaces, CMeshRecords& r) {
+			const char* lb;
+			const char* le;
+			for (; nextLine(cur, end, lb, le); line++)
+			{
+				if (line >= (size_t)nVertices + (size_t)nFaces) break;
+				strutil::SpanTokenizer stokenizer(lb, le, " \r\n");
+				if (line < (size_t)nVertices)
+				{
+					CPoint p;
+					for (int j = 0; j < 3; j++)
+					{
+						stokenizer.nextToken();
+						p[j] = parseFloat(stokenizer);
+					}
+					r.vertexId.push_back((int)line + 1);
+					r.vertexPoint.push_back(p);
+					r.vertexString.push_back(CTextRange());
+					continue;
+				}
+				stokenizer.nextToken();
+				int n = parseInt(stokenizer);
+				assert(n == 3);
+				for (int j = 0; j < 3; j++)
+				{
+					stokenizer.nextToken();
+					r.cornerVertex.push_back(parseInt(stokenizer) + 1);
+				}
+				r.endFace(-1, CTextRange());
+			}
+		};
+	};
+}
+
+#endif //_MESHLIB_MESH_PARSER_H_ defined
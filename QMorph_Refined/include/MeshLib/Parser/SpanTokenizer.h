@@ -0,0 +1,114 @@
+/*!
+*      \file SpanTokenizer.h
+*      \brief Tokenizer and number parsing over a character range, without copies
+*	   \author SirEnri
+*      \date 17/10/2026
+*
+*/
+
+#ifndef _MESHLIB_SPAN_TOKENIZER_H_
+#define _MESHLIB_SPAN_TOKENIZER_H_
+
+#include <string.h>
+#include <charconv>
+#include <string>
+
+namespace strutil {
+
+	/*!
+	*	\brief Tokenizer over [begin, end)
+	*
+	*	Splits the range with the same rules as Tokenizer, the token is a pointer
+	*	pair into the range, so no string is built for it.
+	*/
+	class SpanTokenizer
+	{
+	public:
+		SpanTokenizer(const char* begin, const char* end, const char* delimiters)
+			: m_begin(begin), m_end(end), m_offset(begin), m_tokenBegin(begin), m_tokenEnd(begin), m_delimiters(delimiters) {};
+
+		bool nextToken() { return nextToken(m_delimiters); };
+
+		bool nextToken(const char* delimiters)
+		{
+			// find the start charater of the next token.
+			const char* i = m_offset;
+			while (i < m_end && isDelimiter(*i, delimiters)) i++;
+			if (i == m_end) {
+				m_offset = m_end;
+				return false;
+			}
+			// find the end of the token.
+			const char* j = i;
+			while (j < m_end && !isDelimiter(*j, delimiters)) j++;
+			m_tokenBegin = i;
+			m_tokenEnd = j;
+			m_offset = j;
+			return true;
+		};
+
+		const char* tokenBegin() const { return m_tokenBegin; };
+		const char* tokenEnd() const { return m_tokenEnd; };
+		size_t tokenLength() const { return m_tokenEnd - m_tokenBegin; };
+		bool tokenEquals(const char* s) const {
+			size_t n = strlen(s);
+			return tokenLength() == n && memcmp(m_tokenBegin, s, n) == 0;
+		};
+		bool tokenStartsWith(char c) const { return m_tokenBegin < m_tokenEnd && *m_tokenBegin == c; };
+		const std::string getToken() const { return std::string(m_tokenBegin, m_tokenEnd); };
+		/*! the token without the leading and trailing characters in chars, like trim */
+		std::string getTrimmedToken(const char* chars) const {
+			const char* b = m_tokenBegin;
+			const char* e = m_tokenEnd;
+			while (b < e && isDelimiter(*b, chars)) b++;
+			while (e > b && isDelimiter(e[-1], chars)) e--;
+			return std::string(b, e);
+		};
+		/*!
+		*	the text between the first '{' and the first '}' of the token, to the end
+		*	of the token if the '}' comes first. Returns false if one of them is missing.
+		*/
+		bool findBracedText(const char*& begin, const char*& end) const {
+			const char* sp = (const char*)memchr(m_tokenBegin, '{', tokenLength());
+			const char* ep = (const char*)memchr(m_tokenBegin, '}', tokenLength());
+			if (sp == NULL || ep == NULL) {
+				return false;
+			}
+			begin = sp + 1;
+			end = ep > sp ? ep : m_tokenEnd;
+			return true;
+		};
+
+	protected:
+		static bool isDelimiter(char c, const char* delimiters) {
+			for (; *delimiters; delimiters++) {
+				if (*delimiters == c) return true;
+			}
+			return false;
+		};
+
+		const char* m_begin;
+		const char* m_end;
+		const char* m_offset;
+		const char* m_tokenBegin;
+		const char* m_tokenEnd;
+		const char* m_delimiters;
+	};
+
+	/*!
+	*	Parse a number at the start of [begin, end) like parseString does through a
+	*	stream: leading white spaces and a plus sign are skipped, the rest after the
+	*	number is ignored. The value is 0 if there is no number.
+	*/
+	template<class T> T parseChars(const char* begin, const char* end) {
+		while (begin < end && (*begin == ' ' || *begin == '\t' || *begin == '\n' || *begin == '\r' || *begin == '\f' || *begin == '\v')) begin++;
+		if (begin < end && *begin == '+') begin++;
+		T value = T();
+		if (std::from_chars(begin, end, value).ec != std::errc()) {
+			return T();
+		}
+		return value;
+	};
+}
+
+#endif //_MESHLIB_SPAN_TOKENIZER_H_ defined
@@ -0,0 +1,430 @@
+#include "CrossFieldSolver.h"
+#include <math.h>
+#include <algorithm>
+
+namespace {
+	// angle in (-PI, PI]
+	double wrapAngle(double a) {
+		a = fmod(a, 2 * PI);
+		if (a > PI) a -= 2 * PI;
+		if (a <= -PI) a += 2 * PI;
+		return a;
+	}
+	// angle in [-PI/4, PI/4), the rest of a turn by quarters
+	double wrapQuarter(double a) {
+		return a - floor(a / (PI / 2) + 0.5) * (PI / 2);
+	}
+
+	Point halfedgeVector(CTMesh* mesh, HalfedgeHandle he) {
+		return mesh->getPoint(mesh->halfedgeTarget(he)) - mesh->getPoint(mesh->halfedgeSource(he));
+	}
+
+	// direction j of the face f is direction (j + matching) % 4 of the face g,
+	// d the shared edge and the angles in the frames of the faces
+	int quarterMatching(double thetaF, double thetaG, double dInF, double dInG) {
+		double transported = thetaF - dInF + dInG;
+		int matching = (int)floor((transported - thetaG) / (PI / 2) + 0.5);
+		return ((matching % 4) + 4) % 4;
+	}
+
+	// walk the faces around the vertex, at every edge the field turns by the
+	// quarter-wrapped difference to the parallel transport. These turns plus the
+	// holonomy of the transport give the index of the vertex times a full turn.
+	// The frame turns of the steps only sum to the holonomy modulo a full turn, it
+	// is wrapped back, the angle defect of a vertex stays below half a turn.
+	// edgeAngles(he, inF, inG) gives the angle of the halfedge in the frames of
+	// its face and of the opposite face, theta(face) the field angle.
+	template<typename EdgeAngles, typename Theta>
+	bool singularAround(CTMesh* mesh, VertexHandle v, EdgeAngles edgeAngles, Theta theta) {
+		CTMesh::VertexIHalfedgeIter vihIter(mesh, v);
+		if (vihIter.end()) {
+			return false;
+		}
+		HalfedgeHandle start = *vihIter;
+		HalfedgeHandle he = start;
+		double holonomy = 0;
+		double turn = 0;
+		do {
+			HalfedgeHandle shared = mesh->halfedgeNext(he);
+			FaceHandle f = mesh->halfedgeFace(shared);
+			FaceHandle g = mesh->halfedgeFace(mesh->halfedgeSym(shared));
+			double inF, inG;
+			edgeAngles(shared, inF, inG);
+			double frameTurn = inG - inF;
+			holonomy += frameTurn;
+			turn += wrapQuarter(theta(g) - theta(f) - frameTurn);
+			he = mesh->halfedgeSym(shared);
+		} while (he != start);
+		return (int)floor((turn + wrapAngle(holonomy)) / (PI / 2) + 0.5) != 0;
+	}
+
+	// the frame buildFrames gives the face
+	struct LocalFrame {
+		Point x, y;
+		double angle(const Point& v) const { return atan2(v * y, v * x); }
+	};
+	LocalFrame faceFrame(CTMesh* mesh, FaceHandle face) {
+		HalfedgeHandle he = mesh->faceHalfedge(face);
+		Point x = halfedgeVector(mesh, he);
+		Point n = x ^ halfedgeVector(mesh, mesh->halfedgeNext(he));
+		x /= x.norm();
+		n /= n.norm();
+		LocalFrame frame;
+		frame.x = x;
+		frame.y = n ^ x;
+		return frame;
+	}
+}
+
+CrossFieldSolver& CToolMesh::crossFieldSolver() {
+	if (!builtinCrossFieldSolver) {
+		builtinCrossFieldSolver = std::make_shared<CrossFieldSolver>();
+		builtinCrossFieldSolver->setMesh(this);
+	}
+	return *builtinCrossFieldSolver;
+}
+
+void CrossFieldSolver::setMesh(CTMesh* mesh) {
+	this->mesh = mesh;
+}
+
+void CrossFieldSolver::clearConstraints() {
+	boundaryConstraints = false;
+	constraints.clear();
+}
+
+void CrossFieldSolver::addBoundaryConstraints() {
+	boundaryConstraints = true;
+}
+
+void CrossFieldSolver::addConstraint(FaceHandle face, Point direction) {
+	constraints.push_back(std::make_pair(face, direction));
+}
+
+void CrossFieldSolver::buildFrames() {
+	faces.clear();
+	faceIndex.clear();
+	frameX.clear();
+	frameY.clear();
+	for (CTMesh::FaceIter fIter(mesh); !fIter.end(); fIter++) {
+		LocalFrame frame = faceFrame(mesh, *fIter);
+		faceIndex[*fIter] = (int)faces.size();
+		faces.push_back(*fIter);
+		frameX.push_back(frame.x);
+		frameY.push_back(frame.y);
+	}
+}
+
+double CrossFieldSolver::frameAngle(int face, const Point& v) const {
+	return atan2(v * frameY[face], v * frameX[face]);
+}
+
+void CrossFieldSolver::assemble(Matrix& A, Eigen::VectorXcd& b) {
+	int n = (int)faces.size();
+	std::vector<Eigen::Triplet<Complex> > entries;
+	entries.reserve(4 * n);
+	Eigen::VectorXd diagonal = Eigen::VectorXd::Zero(n);
+	b = Eigen::VectorXcd::Zero(n);
+
+	for (CTMesh::EdgeIter eIter(mesh); !eIter.end(); eIter++) {
+		if (mesh->isBoundary(*eIter)) {
+			continue;
+		}
+		HalfedgeHandle he = mesh->edgeHalfedge(*eIter, 0);
+		int f = faceIndex[mesh->halfedgeFace(he)];
+		int g = faceIndex[mesh->halfedgeFace(mesh->halfedgeSym(he))];
+		Point d = mesh->getPoint(mesh->halfedgeTarget(he)) - mesh->getPoint(mesh->halfedgeSource(he));
+		Complex r = std::polar(1.0, 4 * (frameAngle(g, d) - frameAngle(f, d)));
+		diagonal[f] += 1;
+		diagonal[g] += 1;
+		entries.push_back(Eigen::Triplet<Complex>(g, f, -r));
+		entries.push_back(Eigen::Triplet<Complex>(f, g, -std::conj(r)));
+	}
+
+	// the power vectors of the constraints of a face are summed, two boundary
+	// edges at a right angle agree, other angles give their mean
+	std::vector<Complex> target(n, Complex(0, 0));
+	std::vector<char> constrained(n, 0);
+	if (boundaryConstraints) {
+		for (CTMesh::EdgeIter eIter(mesh); !eIter.end(); eIter++) {
+			if (!mesh->isBoundary(*eIter)) {
+				continue;
+			}
+			HalfedgeHandle he = mesh->edgeHalfedge(*eIter, 0);
+			if (mesh->halfedgeFace(he) == NULL) {
+				he = mesh->halfedgeSym(he);
+			}
+			int f = faceIndex[mesh->halfedgeFace(he)];
+			Point d = mesh->getPoint(mesh->halfedgeTarget(he)) - mesh->getPoint(mesh->halfedgeSource(he));
+			target[f] += std::polar(1.0, 4 * frameAngle(f, d));
+			constrained[f] = 1;
+		}
+	}
+	for (size_t i = 0; i < constraints.size(); i++) {
+		std::unordered_map<FaceHandle, int>::const_iterator it = faceIndex.find(constraints[i].first);
+		if (it == faceIndex.end()) {
+			continue;
+		}
+		target[it->second] += std::polar(1.0, 4 * frameAngle(it->second, constraints[i].second));
+		constrained[it->second] = 1;
+	}
+	bool any = false;
+	for (int f = 0; f < n; f++) {
+		if (constrained[f] && std::abs(target[f]) > 1e-12) {
+			diagonal[f] += constraintWeight;
+			b[f] = constraintWeight * target[f] / std::abs(target[f]);
+			any = true;
+		}
+	}
+	// a closed mesh without constraints gets the frame of its first face
+	if (!any && n > 0) {
+		diagonal[0] += constraintWeight;
+		b[0] = constraintWeight;
+	}
+
+	for (int f = 0; f < n; f++) {
+		entries.push_back(Eigen::Triplet<Complex>(f, f, diagonal[f]));
+	}
+	A.resize(n, n);
+	A.setFromTriplets(entries.begin(), entries.end());
+	A.makeCompressed();
+}
+
+bool CrossFieldSolver::solve() {
+	assert(mesh != NULL);
+	buildFrames();
+	Matrix A;
+	Eigen::VectorXcd b;
+	assemble(A, b);
+
+	int nnz = (int)A.nonZeros();
+	bool samePattern = hasPattern
+		&& patternOuter.size() == (size_t)A.outerSize() + 1
+		&& patternInner.size() == (size_t)nnz
+		&& std::equal(patternOuter.begin(), patternOuter.end(), A.outerIndexPtr())
+		&& std::equal(patternInner.begin(), patternInner.end(), A.innerIndexPtr());
+	analyzedPattern = !samePattern;
+	if (!samePattern) {
+		ldlt.analyzePattern(A);
+		patternOuter.assign(A.outerIndexPtr(), A.outerIndexPtr() + A.outerSize() + 1);
+		patternInner.assign(A.innerIndexPtr(), A.innerIndexPtr() + nnz);
+		hasPattern = true;
+		hasFactor = false;
+	}
+	factorized = !hasFactor || !std::equal(factorValues.begin(), factorValues.end(), A.valuePtr());
+	if (factorized) {
+		ldlt.factorize(A);
+		factorValues.assign(A.valuePtr(), A.valuePtr() + nnz);
+		hasFactor = ldlt.info() == Eigen::Success;
+		if (!hasFactor) {
+			cerr << "CrossFieldSolver: the factorization failed" << endl;
+			return false;
+		}
+	}
+	Eigen::VectorXcd u = ldlt.solve(b);
+	if (ldlt.info() != Eigen::Success) {
+		cerr << "CrossFieldSolver: the solve failed" << endl;
+		return false;
+	}
+	writeField(u);
+	return true;
+}
+
+bool CrossFieldSolver::refine(int iterations) {
+	assert(mesh != NULL);
+	buildFrames();
+	Matrix A;
+	Eigen::VectorXcd b;
+	assemble(A, b);
+
+	int n = (int)faces.size();
+	Eigen::VectorXcd u = Eigen::VectorXcd::Zero(n);
+	for (int f = 0; f < n; f++) {
+		const std::vector<CPoint>& directions = faces[f]->crossFieldDirection;
+		if (!directions.empty()) {
+			u[f] = std::polar(1.0, 4 * frameAngle(f, directions[0]));
+		}
+	}
+	if (iterations > 0) {
+		Eigen::ConjugateGradient<Matrix, Eigen::Lower | Eigen::Upper> cg;
+		cg.setMaxIterations(iterations);
+		cg.compute(A);
+		u = cg.solveWithGuess(b, u);
+		if (cg.info() == Eigen::NumericalIssue) {
+			cerr << "CrossFieldSolver: the refinement failed" << endl;
+			return false;
+		}
+	}
+	writeField(u);
+	return true;
+}
+
+void CrossFieldSolver::writeField(const Eigen::VectorXcd& u) {
+	int n = (int)faces.size();
+	std::vector<double> theta(n);
+	for (int f = 0; f < n; f++) {
+		theta[f] = std::arg(u[f]) / 4;
+		std::vector<CPoint>& directions = faces[f]->crossFieldDirection;
+		directions.resize(4);
+		for (int j = 0; j < 4; j++) {
+			double a = theta[f] + j * PI / 2;
+			directions[j] = frameX[f] * cos(a) + frameY[f] * sin(a);
+		}
+	}
+
+	// direction j of the face is direction (j + matching) % 4 across the halfedge
+	for (CTMesh::EdgeIter eIter(mesh); !eIter.end(); eIter++) {
+		if (mesh->isBoundary(*eIter)) {
+			continue;
+		}
+		for (int i = 0; i < 2; i++) {
+			HalfedgeHandle he = mesh->edgeHalfedge(*eIter, i);
+			int f = faceIndex[mesh->halfedgeFace(he)];
+			int g = faceIndex[mesh->halfedgeFace(mesh->halfedgeSym(he))];
+			Point d = halfedgeVector(mesh, he);
+			he->crossFieldMatching = quarterMatching(theta[f], theta[g], frameAngle(f, d), frameAngle(g, d));
+		}
+	}
+
+	for (CTMesh::VertexIter vIter(mesh); !vIter.end(); vIter++) {
+		(*vIter)->isSingular = !mesh->isBoundary(*vIter) && isSingular(*vIter, theta);
+	}
+}
+
+bool CrossFieldSolver::isSingular(VertexHandle v, const std::vector<double>& theta) {
+	return singularAround(mesh, v,
+		[this](HalfedgeHandle he, double& inF, double& inG) {
+			Point d = halfedgeVector(mesh, he);
+			inF = frameAngle(faceIndex[mesh->halfedgeFace(he)], d);
+			inG = frameAngle(faceIndex[mesh->halfedgeFace(mesh->halfedgeSym(he))], d);
+		},
+		[this, &theta](FaceHandle f) { return theta[faceIndex[f]]; });
+}
+
+// The faces created since the field was computed get the mean of the transported
+// fields of their neighbours, boundary faces follow their boundary edges only.
+// Faces without a known neighbour wait for the next pass, a few more passes then
+// smooth the new faces among each other. Only the matchings of their halfedges
+// and the singularities of their vertices change.
+void CToolMesh::updateCrossField() {
+	if (!crossFieldReady || crossFieldStale.size() == 0) {
+		return;
+	}
+	std::vector<FaceHandle> stale;
+	for (CSparseProperty<CToolFace, bool>::const_iterator it = crossFieldStale.begin(); it != crossFieldStale.end(); ++it) {
+		stale.push_back(const_cast<FaceHandle>(it->first));
+	}
+	// the map is unordered, the id keeps the result independent of the addresses
+	std::sort(stale.begin(), stale.end(), [](FaceHandle a, FaceHandle b) { return a->id() < b->id(); });
+
+	std::unordered_map<FaceHandle, LocalFrame> frames;
+	std::unordered_map<FaceHandle, double> theta;
+	auto frameOf = [&](FaceHandle face) -> const LocalFrame& {
+		std::unordered_map<FaceHandle, LocalFrame>::iterator it = frames.find(face);
+		if (it == frames.end()) {
+			it = frames.insert(std::make_pair(face, faceFrame(this, face))).first;
+		}
+		return it->second;
+	};
+	// the angle of a face with a field, false for a new face still without one
+	auto thetaOf = [&](FaceHandle face, double& value) {
+		std::unordered_map<FaceHandle, double>::const_iterator it = theta.find(face);
+		if (it != theta.end()) {
+			value = it->second;
+			return true;
+		}
+		if (crossFieldStale.has(face) || face->crossFieldDirection.empty()) {
+			return false;
+		}
+		value = frameOf(face).angle(face->crossFieldDirection[0]);
+		theta[face] = value;
+		return true;
+	};
+
+	const int smoothingPasses = 2;
+	int extraPasses = 0;
+	while (extraPasses < smoothingPasses) {
+		bool assigned = false;
+		bool missing = false;
+		for (size_t i = 0; i < stale.size(); i++) {
+			FaceHandle f = stale[i];
+			const LocalFrame& frame = frameOf(f);
+			std::complex<double> boundarySum(0, 0), neighbourSum(0, 0);
+			for (FaceHalfedgeIter fhIter(f); !fhIter.end(); fhIter++) {
+				HalfedgeHandle he = *fhIter;
+				Point d = halfedgeVector(this, he);
+				FaceHandle g = halfedgeFace(halfedgeSym(he));
+				double thetaG;
+				if (g == NULL) {
+					boundarySum += std::polar(1.0, 4 * frame.angle(d));
+				}
+				else if (thetaOf(g, thetaG)) {
+					neighbourSum += std::polar(1.0, 4 * (thetaG - frameOf(g).angle(d) + frame.angle(d)));
+				}
+			}
+			std::complex<double> sum = std::abs(boundarySum) > 1e-12 ? boundarySum : neighbourSum;
+			if (std::abs(sum) <= 1e-12) {
+				missing = missing || theta.find(f) == theta.end();
+				continue;
+			}
+			if (theta.find(f) == theta.end()) {
+				assigned = true;
+			}
+			theta[f] = std::arg(sum) / 4;
+		}
+		if (missing && assigned) {
+			continue;
+		}
+		extraPasses++;
+	}
+
+	for (size_t i = 0; i < stale.size(); i++) {
+		FaceHandle f = stale[i];
+		const LocalFrame& frame = frameOf(f);
+		double& angle = theta.insert(std::make_pair(f, 0.0)).first->second;
+		std::vector<CPoint>& directions = f->crossFieldDirection;
+		directions.resize(4);
+		for (int j = 0; j < 4; j++) {
+			double a = angle + j * PI / 2;
+			directions[j] = frame.x * cos(a) + frame.y * sin(a);
+		}
+	}
+	crossFieldStale.clear();
+	for (size_t i = 0; i < stale.size(); i++) {
+		invalidateCrossFieldTables(stale[i]);
+	}
+
+	auto edgeAngles = [&](HalfedgeHandle he, double& inF, double& inG) {
+		Point d = halfedgeVector(this, he);
+		inF = frameOf(halfedgeFace(he)).angle(d);
+		inG = frameOf(halfedgeFace(halfedgeSym(he))).angle(d);
+	};
+	auto thetaAt = [&](FaceHandle face) {
+		double value = 0;
+		thetaOf(face, value);
+		return value;
+	};
+	std::vector<VertexHandle> vertices;
+	for (size_t i = 0; i < stale.size(); i++) {
+		for (FaceHalfedgeIter fhIter(stale[i]); !fhIter.end(); fhIter++) {
+			HalfedgeHandle he = *fhIter;
+			vertices.push_back(halfedgeTarget(he));
+			HalfedgeHandle sym = halfedgeSym(he);
+			if (halfedgeFace(sym) == NULL) {
+				continue;
+			}
+			double inF, inG;
+			edgeAngles(he, inF, inG);
+			FaceHandle f = halfedgeFace(he);
+			FaceHandle g = halfedgeFace(sym);
+			he->crossFieldMatching = quarterMatching(thetaAt(f), thetaAt(g), inF, inG);
+			sym->crossFieldMatching = quarterMatching(thetaAt(g), thetaAt(f), inG, inF);
+		}
+	}
+	std::sort(vertices.begin(), vertices.end());
+	vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+	for (size_t i = 0; i < vertices.size(); i++) {
+		VertexHandle v = vertices[i];
+		v->isSingular = !isBoundary(v) && singularAround(this, v, edgeAngles, thetaAt);
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <complex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <Eigen/Sparse>
+#include "ToolMesh.h"
+
+// 4-RoSy field on the faces, solved for u = exp(4i * theta) per face in a frame
+// of the face. Interior edges add |u_g - r * u_f|^2, r turning the frame of f
+// into the frame of g, and constrained faces add weight * |u_f - c_f|^2 on the
+// diagonal, so the sparsity pattern only depends on the connectivity.
+//
+// The symbolic factorization is reused while the pattern stays the same and the
+// numeric one while the matrix stays the same: after a geometry change or with
+// other constraint faces a solve costs one numeric factorization, with other
+// constraint directions on the same faces only the back substitution.
+class CrossFieldSolver
+{
+public:
+	void setMesh(CTMesh* mesh);
+
+	void clearConstraints();
+	// align the faces along the boundary with their boundary edges
+	void addBoundaryConstraints();
+	// align the face with the direction, projected into the plane of the face
+	void addConstraint(FaceHandle face, Point direction);
+	double constraintWeight = 1e3;
+
+	// solve and write crossFieldDirection, crossFieldMatching and isSingular
+	bool solve();
+	// start from crossFieldDirection[0] of the faces, a face without one starts
+	// at zero, and improve it by conjugate gradient iterations instead of the
+	// factorization. Writes the field like solve.
+	bool refine(int iterations);
+
+	// what the last solve had to redo
+	bool analyzedPattern = false;
+	bool factorized = false;
+
+protected:
+	typedef std::complex<double> Complex;
+	typedef Eigen::SparseMatrix<Complex> Matrix;
+
+	void buildFrames();
+	// angle of the vector in the frame of the face
+	double frameAngle(int face, const Point& v) const;
+	void assemble(Matrix& A, Eigen::VectorXcd& b);
+	void writeField(const Eigen::VectorXcd& u);
+	bool isSingular(VertexHandle v, const std::vector<double>& theta);
+
+	CTMesh* mesh = NULL;
+	std::vector<FaceHandle> faces;
+	std::unordered_map<FaceHandle, int> faceIndex;
+	std::vector<Point> frameX, frameY;
+	bool boundaryConstraints = false;
+	std::vector<std::pair<FaceHandle, Point> > constraints;
+
+	Eigen::SimplicialLDLT<Matrix> ldlt;
+	bool hasPattern = false;
+	bool hasFactor = false;
+	std::vector<int> patternOuter, patternInner;
+	std::vector<Complex> factorValues;
+};
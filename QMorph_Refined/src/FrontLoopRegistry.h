@@ -0,0 +1,165 @@
+#pragma once
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include "ToolMesh.h"
+
+// The front loops QMorph works on, each registered by one of its front edges,
+// the head. The current loop is the first one in the order of the policy:
+// ROUND_ROBIN keeps the order of insertion and next() moves the current loop
+// to the tail, SMALLEST_FIRST and LARGEST_FIRST order by the number of front
+// edges of the loop, loops of the same size round robin. The size is counted
+// when a loop is registered and when next() moves it on, a new head of the
+// current loop keeps its place, the walks over the current loop end at it.
+// Lookups by head are hashed, removing a loop walks it once.
+class FrontLoopRegistry
+{
+public:
+	enum Policy { ROUND_ROBIN, SMALLEST_FIRST, LARGEST_FIRST };
+
+	void setMesh(CTMesh* mesh) {
+		this->mesh = mesh;
+	}
+	// reorders the registered loops
+	void setPolicy(Policy policy) {
+		this->policy = policy;
+		order.clear();
+		for (std::unordered_map<HalfedgeHandle, Loop>::iterator it = loops.begin(); it != loops.end(); ++it) {
+			if (policy != ROUND_ROBIN && it->second.size < 0) {
+				it->second.size = loopSize(it->first);
+			}
+			order.insert(key(it->first, it->second));
+		}
+	}
+	Policy getPolicy() const {
+		return policy;
+	}
+
+	// the head of the current loop, NULL if there is none
+	HalfedgeHandle current() const {
+		return order.empty() ? NULL : order.begin()->head;
+	}
+	size_t size() const {
+		return loops.size();
+	}
+	bool contains(HalfedgeHandle he) const {
+		return loops.find(he) != loops.end();
+	}
+
+	void pushHead(HalfedgeHandle he) {
+		insert(he, --headSeq);
+	}
+	void pushTail(HalfedgeHandle he) {
+		insert(he, ++tailSeq);
+	}
+	// drop the current loop
+	void popCurrent() {
+		if (!order.empty()) {
+			erase(order.begin()->head);
+		}
+	}
+	// the current loop goes on from another front edge, it stays in front
+	void replaceCurrent(HalfedgeHandle he) {
+		if (order.empty()) {
+			pushHead(he);
+			return;
+		}
+		assert(mesh->isFront(he));
+		HalfedgeHandle old = current();
+		Loop loop = loops[old];
+		erase(old);
+		erase(he);
+		loops[he] = loop;
+		order.insert(key(he, loop));
+	}
+	// move the current loop behind the others of its rank, false if no loop is left
+	bool next() {
+		HalfedgeHandle he = current();
+		if (he == NULL) {
+			return false;
+		}
+		Loop& loop = loops[he];
+		order.erase(key(he, loop));
+		loop.seq = ++tailSeq;
+		if (policy != ROUND_ROBIN) {
+			loop.size = loopSize(he);
+		}
+		order.insert(key(he, loop));
+		return true;
+	}
+	// remove every loop registered by a front edge of the loop of he
+	void removeLoop(HalfedgeHandle he) {
+		HalfedgeHandle heIter = he;
+		do {
+			erase(heIter);
+		} while (heIter = mesh->getNextFe(heIter), heIter != he);
+	}
+
+	// the heads in the order of the policy
+	std::vector<HalfedgeHandle> heads() const {
+		std::vector<HalfedgeHandle> result;
+		for (std::set<Key>::const_iterator it = order.begin(); it != order.end(); ++it) {
+			result.push_back(it->head);
+		}
+		return result;
+	}
+
+protected:
+	struct Loop {
+		int size = -1;	// -1 while the policy does not need it
+		long long seq = 0;
+	};
+	struct Key {
+		long long rank;
+		long long seq;
+		HalfedgeHandle head;
+		bool operator<(const Key& other) const {
+			if (rank != other.rank) return rank < other.rank;
+			return seq < other.seq;
+		}
+	};
+
+	Key key(HalfedgeHandle he, const Loop& loop) const {
+		Key k;
+		k.rank = policy == SMALLEST_FIRST ? loop.size : policy == LARGEST_FIRST ? -loop.size : 0;
+		k.seq = loop.seq;
+		k.head = he;
+		return k;
+	}
+
+	int loopSize(HalfedgeHandle he) const {
+		int count = 0;
+		HalfedgeHandle heIter = he;
+		do {
+			count++;
+		} while (heIter = mesh->getNextFe(heIter), heIter != he);
+		return count;
+	}
+
+	void insert(HalfedgeHandle he, long long seq) {
+		assert(mesh->isFront(he));
+		erase(he);
+		Loop loop;
+		loop.seq = seq;
+		if (policy != ROUND_ROBIN) {
+			loop.size = loopSize(he);
+		}
+		loops[he] = loop;
+		order.insert(key(he, loop));
+	}
+	void erase(HalfedgeHandle he) {
+		std::unordered_map<HalfedgeHandle, Loop>::iterator it = loops.find(he);
+		if (it == loops.end()) {
+			return;
+		}
+		order.erase(key(he, it->second));
+		loops.erase(it);
+	}
+
+	CTMesh* mesh = NULL;
+	Policy policy = ROUND_ROBIN;
+	std::unordered_map<HalfedgeHandle, Loop> loops;
+	std::set<Key> order;
+	long long headSeq = 0;
+	long long tailSeq = 0;
+};
@@ -0,0 +1,219 @@
+#pragma once
+#include <assert.h>
+#include <unordered_map>
+#include <Mesh/Property.h>
+
+class CToolHalfedge;
+
+// The front loops as sequences of front edges in implicit treaps, the order of
+// a sequence is the nextFe order. A loop is a closed sequence, its first edge
+// follows its last. Linking and cutting split and concatenate sequences, the
+// size of a loop and the number of steps between two of its edges then cost
+// O(log n) instead of a walk along nextFe.
+//
+// CToolMesh mirrors every setNextFe and setPrevFe into the sequences, a deleted
+// halfedge leaves its sequence when the mesh erases its properties.
+class FrontSequence : public MeshLib::CPropertyBase<CToolHalfedge>
+{
+public:
+	// next of a is b: a becomes the end of its sequence, b the start of its own,
+	// then the two are joined, or closed into a loop if they are the same
+	void link(const CToolHalfedge* a, const CToolHalfedge* b) {
+		Node* na = node(a);
+		Node* nb = node(b);
+		cutAfter(na);
+		cutBefore(nb);
+		Node* ra = root(na);
+		Node* rb = root(nb);
+		if (ra == rb) {
+			ra->closed = true;
+		}
+		else {
+			merge(ra, rb)->closed = false;
+		}
+	}
+	// take the halfedge out of its sequence, the rest stays a sequence
+	void isolate(const CToolHalfedge* he) {
+		std::unordered_map<const CToolHalfedge*, Node>::iterator it = nodes.find(he);
+		if (it != nodes.end()) {
+			detach(&it->second);
+		}
+	}
+
+	bool contains(const CToolHalfedge* he) const {
+		return nodes.find(he) != nodes.end();
+	}
+	bool isLoop(const CToolHalfedge* he) const {
+		const Node* n = find(he);
+		return n != NULL && root(n)->closed;
+	}
+	// number of edges of the sequence of the halfedge
+	int size(const CToolHalfedge* he) const {
+		const Node* n = find(he);
+		return n == NULL ? 1 : root(n)->size;
+	}
+	// steps along nextFe from a until b is reached, at least one: the size of
+	// the loop if a is b. -1 if b cannot be reached.
+	int steps(const CToolHalfedge* a, const CToolHalfedge* b) const {
+		const Node* na = find(a);
+		const Node* nb = find(b);
+		if (na == NULL || nb == NULL || root(na) != root(nb)) {
+			return -1;
+		}
+		const Node* r = root(na);
+		int d = index(nb) - index(na);
+		if (r->closed) {
+			return d > 0 ? d : d + r->size;
+		}
+		return d > 0 ? d : -1;
+	}
+
+	void erase(const CToolHalfedge* key) override {
+		std::unordered_map<const CToolHalfedge*, Node>::iterator it = nodes.find(key);
+		if (it != nodes.end()) {
+			detach(&it->second);
+			nodes.erase(it);
+		}
+	}
+	void clear() override {
+		nodes.clear();
+	}
+	size_t size() const override {
+		return nodes.size();
+	}
+
+protected:
+	struct Node {
+		Node* left = NULL;
+		Node* right = NULL;
+		Node* parent = NULL;
+		unsigned priority = 0;
+		int size = 1;
+		bool closed = false;	// only read at the root
+	};
+
+	Node* node(const CToolHalfedge* he) {
+		std::unordered_map<const CToolHalfedge*, Node>::iterator it = nodes.find(he);
+		if (it == nodes.end()) {
+			it = nodes.insert(std::make_pair(he, Node())).first;
+			it->second.priority = random();
+		}
+		return &it->second;
+	}
+	const Node* find(const CToolHalfedge* he) const {
+		std::unordered_map<const CToolHalfedge*, Node>::const_iterator it = nodes.find(he);
+		return it == nodes.end() ? NULL : &it->second;
+	}
+	unsigned random() {
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		return seed;
+	}
+
+	static int sizeOf(const Node* n) {
+		return n ? n->size : 0;
+	}
+	static void update(Node* n) {
+		n->size = 1 + sizeOf(n->left) + sizeOf(n->right);
+		if (n->left) n->left->parent = n;
+		if (n->right) n->right->parent = n;
+	}
+	static const Node* root(const Node* n) {
+		while (n->parent) n = n->parent;
+		return n;
+	}
+	static Node* root(Node* n) {
+		while (n->parent) n = n->parent;
+		return n;
+	}
+	// position in the sequence
+	static int index(const Node* n) {
+		int i = sizeOf(n->left);
+		for (; n->parent; n = n->parent) {
+			if (n == n->parent->right) {
+				i += sizeOf(n->parent->left) + 1;
+			}
+		}
+		return i;
+	}
+
+	static Node* merge(Node* a, Node* b) {
+		if (!a) return b;
+		if (!b) return a;
+		if (a->priority > b->priority) {
+			a->right = merge(a->right, b);
+			update(a);
+			a->parent = NULL;
+			return a;
+		}
+		b->left = merge(a, b->left);
+		update(b);
+		b->parent = NULL;
+		return b;
+	}
+	// the first k nodes of the tree in a, the rest in b
+	static void split(Node* t, int k, Node*& a, Node*& b) {
+		if (!t) {
+			a = b = NULL;
+			return;
+		}
+		t->parent = NULL;
+		if (sizeOf(t->left) < k) {
+			split(t->right, k - sizeOf(t->left) - 1, t->right, b);
+			update(t);
+			a = t;
+		}
+		else {
+			split(t->left, k, a, t->left);
+			update(t);
+			b = t;
+		}
+		if (a) a->parent = NULL;
+		if (b) b->parent = NULL;
+	}
+
+	// the sequence of n as an open one starting at position k
+	static Node* openAt(Node* n, int k) {
+		Node* r = root(n);
+		Node *a, *b;
+		split(r, k, a, b);
+		Node* result = merge(b, a);
+		result->closed = false;
+		return result;
+	}
+	// n becomes the last of its sequence
+	static void cutAfter(Node* n) {
+		Node* r = root(n);
+		int i = index(n);
+		if (r->closed) {
+			openAt(n, i + 1);
+			return;
+		}
+		Node *a, *b;
+		split(r, i + 1, a, b);
+		a->closed = false;
+		if (b) b->closed = false;
+	}
+	// n becomes the first of its sequence
+	static void cutBefore(Node* n) {
+		Node* r = root(n);
+		int i = index(n);
+		if (r->closed) {
+			openAt(n, i);
+			return;
+		}
+		Node *a, *b;
+		split(r, i, a, b);
+		if (a) a->closed = false;
+		b->closed = false;
+	}
+	static void detach(Node* n) {
+		cutBefore(n);
+		cutAfter(n);
+		n->closed = false;
+	}
+
+	std::unordered_map<const CToolHalfedge*, Node> nodes;
+	unsigned seed = 2463534242u;
+};
@@ -1,4 +1,5 @@
 #include <list>
+#include <algorithm>
 #include<iostream>
 #include<math.h>
 #include"QMorph.h"
@@ -11,7 +12,10 @@ QMorph::QMorph(CTMesh* tarMesh)
 	assert(tarMesh != NULL);
 	mesh = tarMesh;
 	smoother.setMesh(mesh);
-	mesh->calculateCrossField();
+	frontLoops.setMesh(mesh);
+	if (!mesh->hasCrossField()) {
+		mesh->calculateCrossField();
+	}
 }
 
 void QMorph::findPointForDebug(Point coord, Point target) {
@@ -397,20 +401,53 @@ int QMorph::doEdgeRecovery() {
 }
 
 
+// the interior vertices within smoothBand rings of the vertices changed since the
+// last smoothing, in the order the rings are reached
+std::vector<VertexHandle> QMorph::smoothBandVertices() {
+	std::vector<VertexHandle> ring = mesh->takeChangedVertices();
+	std::unordered_set<VertexHandle> reached(ring.begin(), ring.end());
+	std::vector<VertexHandle> band(ring);
+	for (int k = 0; k < smoothBand && !ring.empty(); k++) {
+		std::vector<VertexHandle> nextRing;
+		for (VertexHandle v : ring) {
+			for (CTMesh::VertexVertexIter vvIter(mesh, v); !vvIter.end(); vvIter++) {
+				if (reached.insert(*vvIter).second) {
+					nextRing.push_back(*vvIter);
+				}
+			}
+		}
+		band.insert(band.end(), nextRing.begin(), nextRing.end());
+		ring.swap(nextRing);
+	}
+	band.erase(std::remove_if(band.begin(), band.end(), [this](VertexHandle v) {
+		return mesh->isBoundary(v);
+	}), band.end());
+	smoothSaved = mesh->numInteriorVertices() - (int)band.size();
+	smoothSavedTotal += smoothSaved;
+	smoothBandCount++;
+	return band;
+}
+
 int QMorph::doSmooth(int epoch = 3) {
-	int i = 0;
-	while (i < epoch) {
-		reportIter(i++, "doSmooth");
+	std::vector<VertexHandle> vertices;
+	if (smoothBand >= 0 && !smoothFull) {
+		vertices = smoothBandVertices();
+	}
+	else {
+		if (smoothBand >= 0) {
+			mesh->takeChangedVertices();
+		}
 		for (CTMesh::VertexIter vIter(mesh); !vIter.end(); vIter++) {
-			int numQuad = mesh->numQuad(*vIter);
-			int numTriangles = mesh->numTriangles(*vIter);
-			bool isBoundary = mesh->isBoundary(*vIter);
-			if (isBoundary) {
-				continue;
+			if (!mesh->isBoundary(*vIter)) {
+				vertices.push_back(*vIter);
 			}
-			smoother.triangleInteriorSmooth(*vIter, true);
 		}
+		smoothFull = false;
 	}
+	// the moves of the smoothing itself are not changes for the next band
+	mesh->trackGeometryChanges(false);
+	smoother.smoothVertices(vertices, false, epoch);
+	mesh->trackGeometryChanges(smoothBand >= 0);
 	//int i = 0;
 	//while (i < epoch) {
 	//	reportIter(i++, "doSmooth");
@@ -582,9 +619,10 @@ void QMorph::updateFeClassification(HalfedgeHandle feList) {
 	}
 	// This assertion asures a circle stores in the list.
 	mesh->topology_assert(mesh->isFront(feList), { feList });
+	// only the angles at the vertices moved or rebuilt since the last pass are measured again
 	HalfedgeHandle fe = feList;
 	do {
-		mesh->setNextFe(fe, mesh->getNextFe(fe));
+		mesh->classifyFront(fe, mesh->getNextFe(fe));
 		fe = mesh->getNextFe(fe);
 	} while (fe != feList);
 }
@@ -753,13 +791,10 @@ int QMorph::doSeam()
 
 // result including fe1 & fe2 itself, means if getNextFe(fe1)==fe2, return 2
 int QMorph::countFeToFe(HalfedgeHandle fe1, HalfedgeHandle fe2) {
-	int count = 1;
-	HalfedgeHandle feIter = fe1;
-	while (feIter != fe2) {
-		count++;
-		feIter = mesh->getNextFe(feIter);
+	if (fe1 == fe2) {
+		return 1;
 	}
-	return count;
+	return mesh->frontEdgeSteps(fe1, fe2) + 1;
 }
 
 // This function maintains 
@@ -793,27 +828,33 @@ int QMorph::seperateFrontLoop(HalfedgeHandle cutPos) {
 		return 0;
 	}
 
-	HalfedgeHandle fe_iter = fe3;
+	// walking from fe3 reaches fe4 first if the cut splits one loop in two,
+	// fe2 if it joins the loop of fe3 with the one of fe1
 	int count_fe1 = 2, count_fe2 = 2;
 	bool splitFe = false;
-	while (fe_iter != fe2) {
-		fe_iter = mesh->getNextFe(fe_iter);
-		count_fe1++;
-		if (fe_iter == fe4) {
+	if (fe3 != fe2) {
+		int toFe2 = mesh->frontEdgeSteps(fe3, fe2);
+		int toFe4 = mesh->frontEdgeSteps(fe3, fe4);
+		if (toFe4 >= 0 && (toFe2 < 0 || toFe4 <= toFe2)) {
 			splitFe = true;
-			break;
+			count_fe1 += toFe4;
+		}
+		else {
+			count_fe1 += toFe2;
 		}
 	}
 	if (count_fe1 < 4) {
 		return -1;
 	}
-	fe_iter = fe1;
-	while (fe_iter != fe4) {
-		fe_iter = mesh->getNextFe(fe_iter);
-		count_fe2++;
-		if (fe_iter == fe2) {
+	if (fe1 != fe4) {
+		int toFe4 = mesh->frontEdgeSteps(fe1, fe4);
+		int toFe2 = mesh->frontEdgeSteps(fe1, fe2);
+		if (toFe2 >= 0 && (toFe4 < 0 || toFe2 <= toFe4)) {
 			assert(splitFe);
-			break;
+			count_fe2 += toFe2;
+		}
+		else {
+			count_fe2 += toFe4;
 		}
 	}
 	if (count_fe2 < 4) {
@@ -860,8 +901,15 @@ int QMorph::doQMorphProcess() {
 	this->initFrontEdgeGroup();
 	while (doSmooth(), globalIter++, getFrontEdgeGroup())
 	{
+#ifdef _DEBUG
 		highlightAllFes();
 		Sleep(500);
+#endif
+		if (reorderInterval > 0 && globalIter % reorderInterval == 0) {
+			mesh->reorderElements();
+		}
+		// the faces the last step created take the field of their neighbours
+		mesh->updateCrossField();
 		if (frontEdgeGroupSize(getFrontEdgeGroup()) == 4) {
 			HalfedgeHandle he = getFrontEdgeGroup();
 			mesh->setSide(he, mesh->getNextFe(he), NULL);
@@ -891,6 +939,7 @@ int QMorph::doQMorphProcess() {
 		
 		doEdgeRecovery();
 		proceedNextFeLoop();
+		if (getenv("QM_GUARD")) smoothFull = true;
 		if (getFrontEdgeGroup()) {
 			switchFrontEdgeGroup();
 		}
@@ -4,7 +4,9 @@
 
 #include "ToolMesh.h"
 #include "Smoother.h"
+#include "FrontLoopRegistry.h"
 #include <queue>
+#include <unordered_set>
 
 typedef enum SideDefineResult {
 	Succeeded,
@@ -80,6 +82,42 @@ public:
 	int doCornerGenerate();
 	int initFrontEdgeGroup();
 	int doSmooth(int epoch); //when debug, set easySmooth to true
+	// sort the element lists along the Morton curve every interval front iterations,
+	// 0 to never. Only the iteration order changes, see CBaseMesh::reorderElements
+	void setReorderInterval(int interval) {
+		reorderInterval = interval;
+	}
+	// smooth only the vertices within width rings of the ones moved or given a new
+	// face since the last smoothing, -1 to smooth every interior vertex
+	void setSmoothBand(int width) {
+		smoothBand = width;
+		mesh->trackGeometryChanges(width >= 0);
+	}
+	// interior vertices left out by the last doSmooth, by all of them, and the
+	// number of doSmooth calls that worked on a band
+	int getSmoothSaved() const {
+		return smoothSaved;
+	}
+	long long getSmoothSavedTotal() const {
+		return smoothSavedTotal;
+	}
+	int getSmoothBandCount() const {
+		return smoothBandCount;
+	}
+	// smooth on threads, the vertices in color classes, 1 for the serial sweep in
+	// the order of the vertex list. The order differs, so may the quads.
+	void setSmoothThreads(int threads) {
+		smoother.setThreads(threads);
+	}
+	// stop the smoothing before the epoch count once no vertex moves by more than
+	// the tolerance, relative to its edges, 0 for every epoch
+	void setSmoothTolerance(double tolerance) {
+		smoother.setTolerance(tolerance);
+	}
+	// the residual of every smoothing sweep
+	void setSmoothResidualCallback(const std::function<void(const SmoothResidual&)>& callback) {
+		smoother.setResidualCallback(callback);
+	}
 	void highlightAllSides();
 	void initQuadTree() {
 		/*Rectangle* rootRec = new Rectangle(0, 16, 0, 16);
@@ -106,67 +144,62 @@ public:
 private:
 	CTMesh* mesh;
 	Smoother smoother;
+	int reorderInterval = 0;
+	int smoothBand = -1;
+	bool smoothFull = false;
+	int smoothSaved = 0;
+	long long smoothSavedTotal = 0;
+	int smoothBandCount = 0;
+	// the interior vertices doSmooth works on when the band is set
+	std::vector<VertexHandle> smoothBandVertices();
 
-	list<HalfedgeHandle> frontEdgeGroups;
+	FrontLoopRegistry frontLoops;
 	int frontEdgeGroupSize(HalfedgeHandle he) {
 		assert(mesh->isFront(he));
-		int count = 0;
-		HalfedgeHandle heIter = he;
-		do {
-			count++;
-		} while (
-			heIter = mesh->getNextFe(heIter), heIter != he);
-		return count;
+		return mesh->frontEdgeSize(he);
 	}
 
 	void pushHeadFrontEdgeGroup(HalfedgeHandle he) {
-		assert(mesh->isFront(he));
-		frontEdgeGroups.push_front(he);
+		frontLoops.pushHead(he);
 	}
 
 	void pushTailFrontEdgeGroup(HalfedgeHandle he) {
-		assert(mesh->isFront(he));
-		frontEdgeGroups.push_back(he);
+		frontLoops.pushTail(he);
 	}
 
 	// param he: any frontedge in the group
 	void removeFrontEdgeGroup(HalfedgeHandle he) {
-		HalfedgeHandle heIter = he;
-		do {
-			frontEdgeGroups.remove(heIter);
-		} while (
-			heIter = mesh->getNextFe(heIter), heIter != he);
+		frontLoops.removeLoop(he);
 	}
 
 	bool isFrontEdgeGroupIndex(HalfedgeHandle he) {
-		return find(frontEdgeGroups.begin(), frontEdgeGroups.end(), he) != frontEdgeGroups.end();
+		return frontLoops.contains(he);
 	}
 
 	HalfedgeHandle popFrontEdgeGroup() {
-		HalfedgeHandle he = frontEdgeGroups.front();
-		frontEdgeGroups.pop_front();
+		HalfedgeHandle he = frontLoops.current();
+		frontLoops.popCurrent();
 		return he;
 	}
 
 public:
 	HalfedgeHandle getFrontEdgeGroup() {
-		if (frontEdgeGroups.size() > 0) {
-			return frontEdgeGroups.front();
-		}
-		else {
-			return NULL;
-		}
+		return frontLoops.current();
 	}
 	bool switchFrontEdgeGroup() {
-		pushTailFrontEdgeGroup(getFrontEdgeGroup());
-		popFrontEdgeGroup();
-		return getFrontEdgeGroup() != NULL;
+		return frontLoops.next();
+	}
+	// which front loop is worked on next, round robin by default
+	void setFrontLoopPolicy(FrontLoopRegistry::Policy policy) {
+		frontLoops.setPolicy(policy);
+	}
+	size_t frontLoopCount() const {
+		return frontLoops.size();
 	}
 private:
 
 	void updateHeadFrontEdgeGroup(HalfedgeHandle he) {
-		popFrontEdgeGroup();
-		pushHeadFrontEdgeGroup(he);
+		frontLoops.replaceCurrent(he);
 	}
 
 	// these functions only return its finding of side he & its topology state
@@ -197,7 +230,7 @@ public:
 			}
 		}
 		int curve = 1;
-		for (HalfedgeHandle he : frontEdgeGroups) {
+		for (HalfedgeHandle he : frontLoops.heads()) {
 			he = mesh->halfedgeSym(he);
 			int i = 1;
 			HalfedgeHandle heIter = he;
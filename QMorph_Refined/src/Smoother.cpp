@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "Smoother.h"
 #include"QMorph.h"
 #include"util.h"
@@ -199,20 +200,35 @@ int Smoother::doBoundarySmooth(HalfedgeHandle bhe, int epoch) {
 	HalfedgeHandle he = bhe;
 	HalfedgeHandle he_start = he;
 	int i = 0;
+	SmoothResidual residual;
 	while (i < epoch) {
+		double sumSquares = 0;
 		do {
 			reportIter(i++, "doBoundarySmooth");
 			if (!mesh->isBoundary(mesh->halfedgeSym(he))) {
+				VertexHandle bV = mesh->halfedgeSource(he);
+				Point old = mesh->getPoint(bV);
 				boundaryEdgeSmooth(he);
+				if (tracksResidual()) {
+					double d = relativeDisplacement(bV, old);
+					residual.maxDisplacement = std::max(residual.maxDisplacement, d);
+					sumSquares += d * d;
+					residual.vertices++;
+				}
 			}
 			he = mesh->getNextFe(he);
 		} while (he != he_start);
+		if (endSweep(residual, sumSquares)) {
+			break;
+		}
 	}
 	return 0;
 }
 
 void Smoother::doTriangleSmooth(int epoch) {
+	SmoothResidual residual;
 	while (epoch > 0) {
+		double sumSquares = 0;
 		CTMesh::VertexIter vIter(mesh);
 		for (; !vIter.end(); vIter++) {
 			if (!mesh->isBoundary(*vIter)
@@ -221,10 +237,227 @@ void Smoother::doTriangleSmooth(int epoch) {
 				;
 			}
 			else if (!mesh->isBoundary(*vIter) && !mesh->isFront(*vIter)) {
+				Point old = mesh->getPoint(*vIter);
 				triangleInteriorSmooth(*vIter, true);
+				if (tracksResidual()) {
+					double d = relativeDisplacement(*vIter, old);
+					residual.maxDisplacement = std::max(residual.maxDisplacement, d);
+					sumSquares += d * d;
+					residual.vertices++;
+				}
 			}
 		}
 		epoch--;
+		if (endSweep(residual, sumSquares)) {
+			break;
+		}
+	}
+
+}
+
+void Smoother::setTolerance(double tolerance) {
+	this->tolerance = tolerance;
+}
+
+double Smoother::getTolerance() const {
+	return tolerance;
+}
+
+void Smoother::setResidualCallback(const std::function<void(const SmoothResidual&)>& callback) {
+	residualCallback = callback;
+}
+
+double Smoother::relativeDisplacement(VertexHandle v, const Point& old) {
+	double length = 0;
+	int count = 0;
+	for (CTMesh::VertexVertexIter vvIter(mesh, v); !vvIter.end(); vvIter++) {
+		length += (mesh->getPoint(*vvIter) - mesh->getPoint(v)).norm();
+		count++;
+	}
+	double displacement = (mesh->getPoint(v) - old).norm();
+	return length > 0 ? displacement * count / length : displacement;
+}
+
+// residual holds the max and the count of the sweep, it is reset for the next one
+bool Smoother::endSweep(SmoothResidual& residual, double sumSquares) {
+	if (!tracksResidual()) {
+		return false;
+	}
+	residual.rmsDisplacement = residual.vertices > 0 ? sqrt(sumSquares / residual.vertices) : 0;
+	if (residualCallback) {
+		residualCallback(residual);
 	}
+	bool converged = tolerance > 0 && residual.maxDisplacement < tolerance;
+	residual.sweep++;
+	residual.vertices = 0;
+	residual.maxDisplacement = 0;
+	residual.rmsDisplacement = 0;
+	return converged;
+}
+
+void Smoother::setThreads(int threads) {
+	pool = threads > 1 ? std::make_shared<ThreadPool>(threads) : nullptr;
+}
+
+int Smoother::getThreads() const {
+	return pool ? pool->size() : 1;
+}
 
+// the vertices whose points the kernel reads for the vertex. The 1-ring for the
+// triangle kernel. For the quad one the vertices of the faces of the vertex, and
+// of the faces of every boundary vertex among them, which getDelC reads.
+static void smoothStencil(CTMesh* mesh, VertexHandle vertex, bool quad, std::vector<VertexHandle>& stencil) {
+	stencil.clear();
+	if (!quad) {
+		for (CTMesh::VertexVertexIter vvIter(mesh, vertex); !vvIter.end(); vvIter++) {
+			stencil.push_back(*vvIter);
+		}
+		return;
+	}
+	for (CTMesh::VertexFaceIter vfIter(mesh, vertex); !vfIter.end(); vfIter++) {
+		for (CTMesh::FaceVertexIter fvIter(*vfIter); !fvIter.end(); fvIter++) {
+			stencil.push_back(*fvIter);
+		}
+	}
+	size_t faceVertices = stencil.size();
+	for (size_t i = 0; i < faceVertices; i++) {
+		if (stencil[i] == vertex || !mesh->isBoundary(stencil[i])) {
+			continue;
+		}
+		for (CTMesh::VertexFaceIter vfIter(mesh, stencil[i]); !vfIter.end(); vfIter++) {
+			for (CTMesh::FaceVertexIter fvIter(*vfIter); !fvIter.end(); fvIter++) {
+				stencil.push_back(*fvIter);
+			}
+		}
+	}
+}
+
+// vertices per block, consecutive vertices of a mesh in Morton order are close
+// and their blocks touch few others
+static const size_t smoothBlockSize = 256;
+
+// greedy, each block takes the first color none of the blocks its stencils reach
+// has yet. Both stencils are symmetric, a vertex is in the stencil of the ones in
+// its own.
+std::vector<std::vector<std::pair<size_t, size_t>>> Smoother::colorBlocks(const std::vector<VertexHandle>& vertices, bool quad) {
+	colorPass++;
+	for (size_t i = 0; i < vertices.size(); i++) {
+		vertices[i]->smoothBlock = (int)(i / smoothBlockSize);
+		vertices[i]->smoothColorPass = colorPass;
+	}
+	size_t blocks = (vertices.size() + smoothBlockSize - 1) / smoothBlockSize;
+	std::vector<int> color(blocks, -1);
+	std::vector<size_t> taken;	// the last block that reached the color
+	std::vector<std::vector<std::pair<size_t, size_t>>> classes;
+	std::vector<VertexHandle> stencil;
+	for (size_t block = 0; block < blocks; block++) {
+		size_t begin = block * smoothBlockSize;
+		size_t end = std::min(begin + smoothBlockSize, vertices.size());
+		for (size_t i = begin; i < end; i++) {
+			smoothStencil(mesh, vertices[i], quad, stencil);
+			for (VertexHandle u : stencil) {
+				if (u->smoothColorPass == colorPass && color[u->smoothBlock] >= 0 && u->smoothBlock != (int)block) {
+					taken[color[u->smoothBlock]] = block;
+				}
+			}
+		}
+		int c = 0;
+		while (c < (int)classes.size() && taken[c] == block) {
+			c++;
+		}
+		if (c == (int)classes.size()) {
+			classes.emplace_back();
+			taken.push_back(blocks);
+		}
+		color[block] = c;
+		classes[c].push_back(std::make_pair(begin, end));
+	}
+	return classes;
+}
+
+void Smoother::parallelSmooth(const std::vector<VertexHandle>& vertices, bool quad, int epoch) {
+	std::vector<std::vector<std::pair<size_t, size_t>>> classes = colorBlocks(vertices, quad);
+	// max and sum of squares of the displacements per block of a class, added up
+	// in the order of the blocks whatever the threads
+	std::vector<std::pair<double, double>> blockResiduals;
+	SmoothResidual residual;
+	for (int i = 0; i < epoch; i++) {
+		reportIter(i, "parallelSmooth");
+		double sumSquares = 0;
+		for (const std::vector<std::pair<size_t, size_t>>& colorClass : classes) {
+			blockResiduals.assign(colorClass.size(), std::make_pair(0.0, 0.0));
+			std::function<void(size_t, size_t)> sweep = [&](size_t begin, size_t end) {
+				for (size_t block = begin; block < end; block++) {
+					for (size_t j = colorClass[block].first; j < colorClass[block].second; j++) {
+						Point old = mesh->getPoint(vertices[j]);
+						if (quad) {
+							quadriInteriorSmooth(vertices[j]);
+						}
+						else {
+							triangleInteriorSmooth(vertices[j], true);
+						}
+						if (tracksResidual()) {
+							double d = relativeDisplacement(vertices[j], old);
+							blockResiduals[block].first = std::max(blockResiduals[block].first, d);
+							blockResiduals[block].second += d * d;
+						}
+					}
+				}
+			};
+			if (pool) {
+				pool->parallelFor(colorClass.size(), sweep, 2);
+			}
+			else {
+				sweep(0, colorClass.size());
+			}
+			for (const std::pair<double, double>& blockResidual : blockResiduals) {
+				residual.maxDisplacement = std::max(residual.maxDisplacement, blockResidual.first);
+				sumSquares += blockResidual.second;
+			}
+		}
+		residual.vertices = (int)vertices.size();
+		if (endSweep(residual, sumSquares)) {
+			break;
+		}
+	}
+}
+
+void Smoother::smoothVertices(const std::vector<VertexHandle>& vertices, bool quad, int epoch) {
+	if (pool) {
+		parallelSmooth(vertices, quad, epoch);
+		return;
+	}
+	SmoothResidual residual;
+	for (int i = 0; i < epoch; i++) {
+		reportIter(i, "smoothVertices");
+		double sumSquares = 0;
+		for (VertexHandle v : vertices) {
+			Point old = mesh->getPoint(v);
+			if (quad) {
+				quadriInteriorSmooth(v);
+			}
+			else {
+				triangleInteriorSmooth(v, true);
+			}
+			if (tracksResidual()) {
+				double d = relativeDisplacement(v, old);
+				residual.maxDisplacement = std::max(residual.maxDisplacement, d);
+				sumSquares += d * d;
+			}
+		}
+		residual.vertices = (int)vertices.size();
+		if (endSweep(residual, sumSquares)) {
+			break;
+		}
+	}
+}
+
+void Smoother::doParallelTriangleSmooth(int epoch) {
+	std::vector<VertexHandle> vertices;
+	for (CTMesh::VertexIter vIter(mesh); !vIter.end(); vIter++) {
+		if (!mesh->isBoundary(*vIter) && mesh->numQuad(*vIter) == 0 && !mesh->isFront(*vIter)) {
+			vertices.push_back(*vIter);
+		}
+	}
+	parallelSmooth(vertices, false, epoch);
 }
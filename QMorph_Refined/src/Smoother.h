@@ -1,6 +1,18 @@
 #pragma once
+#include <functional>
+#include <memory>
+#include <vector>
 #include "ToolMesh.h"
+#include "ThreadPool.h"
 
+// the vertex displacements of one smoothing sweep, each relative to the mean
+// length of the edges of the vertex
+struct SmoothResidual {
+	int sweep = 0;
+	int vertices = 0;
+	double maxDisplacement = 0;
+	double rmsDisplacement = 0;
+};
 
 class Smoother
 {
@@ -13,6 +25,42 @@ public:
 	void quadriInteriorSmooth(VertexHandle);
 	void doTriangleSmooth(int epoch = 3);
 	int doBoundarySmooth(HalfedgeHandle bhe, int epoch = 1);
+	// the threads of the parallel sweeps, 1 to sweep on the calling thread
+	void setThreads(int threads);
+	int getThreads() const;
+	// the vertices cut into blocks of consecutive ones, the blocks in color classes
+	// as [begin, end) ranges. No vertex of a block moves a point a vertex of
+	// another block of the class reads in the kernel: the 1-ring for the triangle
+	// kernel, more for the quad one.
+	std::vector<std::vector<std::pair<size_t, size_t>>> colorBlocks(const std::vector<VertexHandle>& vertices, bool quad);
+	// epoch sweeps of the kernel over the vertices, the color classes one after
+	// another and the blocks of a class across the threads. A block is swept in
+	// the order of the vertices, as the serial sweep does.
+	void parallelSmooth(const std::vector<VertexHandle>& vertices, bool quad, int epoch = 1);
+	// doTriangleSmooth as parallel sweeps
+	void doParallelTriangleSmooth(int epoch = 3);
+	// epoch sweeps of the kernel over the vertices, in their order, or as
+	// parallelSmooth if there are threads
+	void smoothVertices(const std::vector<VertexHandle>& vertices, bool quad, int epoch = 1);
+	// the sweeps stop before the epoch count once no vertex moves by more than the
+	// tolerance, relative to its edges. 0 runs every epoch.
+	void setTolerance(double tolerance);
+	double getTolerance() const;
+	// called with the residual of every sweep, the displacements are only measured
+	// with a callback or a tolerance
+	void setResidualCallback(const std::function<void(const SmoothResidual&)>& callback);
   	CTMesh* mesh;
+private:
+	std::shared_ptr<ThreadPool> pool;
+	int colorPass = 0;
+	double tolerance = 0;
+	std::function<void(const SmoothResidual&)> residualCallback;
+
+	bool tracksResidual() const {
+		return tolerance > 0 || residualCallback;
+	}
+	double relativeDisplacement(VertexHandle v, const Point& old);
+	// reports the sweep, true if it converged
+	bool endSweep(SmoothResidual& residual, double sumSquares);
 };
 
@@ -0,0 +1,94 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads for data parallel loops. parallelFor splits
+// [0, n) into one contiguous range per thread, the calling thread works on the
+// first one and returns when all of them are done, so the writes of one call
+// are seen by everything after it.
+class ThreadPool
+{
+public:
+	explicit ThreadPool(int threads) : parts(threads < 1 ? 1 : threads) {
+		for (int part = 1; part < parts; part++) {
+			workers.emplace_back(&ThreadPool::work, this, part);
+		}
+	}
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+	}
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// the workers and the calling thread
+	int size() const {
+		return parts;
+	}
+	// body(begin, end) over the ranges of [0, n), on the calling thread alone if
+	// n is below grain, where waking the workers costs more than it saves
+	void parallelFor(size_t n, const std::function<void(size_t, size_t)>& body, size_t grain = 1) {
+		if (workers.empty() || n < grain || n < (size_t)size()) {
+			body(0, n);
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			task = &body;
+			count = n;
+			pending = (int)workers.size();
+			generation++;
+		}
+		wake.notify_all();
+		body(0, n / size());
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [this] { return pending == 0; });
+		task = NULL;
+	}
+
+protected:
+	void work(int part) {
+		unsigned long long seen = 0;
+		for (;;) {
+			const std::function<void(size_t, size_t)>* body;
+			size_t n;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&] { return stopping || generation != seen; });
+				if (stopping) {
+					return;
+				}
+				seen = generation;
+				body = task;
+				n = count;
+			}
+			(*body)(n * part / size(), n * (part + 1) / size());
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (--pending == 0) {
+					done.notify_one();
+				}
+			}
+		}
+	}
+
+	const int parts;
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	const std::function<void(size_t, size_t)>* task = NULL;
+	size_t count = 0;
+	int pending = 0;
+	unsigned long long generation = 0;
+	bool stopping = false;
+};
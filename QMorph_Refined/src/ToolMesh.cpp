@@ -15,11 +15,20 @@ VertexHandle CToolMesh::edgeVertex2(EdgeHandle edge) {
 }
 
 CToolMesh::CToolMesh() {
+	halfedgeProperties().add(&frontAttribute);
+	halfedgeProperties().add(&frontSequence);
+	faceProperties().add(&crossFieldStale);
+	vertexProperties().add(&vertexCrossFieldTable);
+	edgeProperties().add(&edgeCrossFieldTable);
+	vertexProperties().add(&changedVertices);
 }
 
 
 
 int CToolMesh::frontEdgeSize(HalfedgeHandle fe) {
+	if (frontSequence.isLoop(fe)) {
+		return frontSequence.size(fe);
+	}
 	int size = 0;
 	HalfedgeHandle he = fe;
 	do {
@@ -29,6 +38,19 @@ int CToolMesh::frontEdgeSize(HalfedgeHandle fe) {
 	return size;
 }
 
+int CToolMesh::frontEdgeSteps(HalfedgeHandle fe1, HalfedgeHandle fe2) {
+	if (frontSequence.isLoop(fe1)) {
+		return frontSequence.steps(fe1, fe2);
+	}
+	int steps = 0;
+	HalfedgeHandle he = fe1;
+	do {
+		steps++;
+		he = getNextFe(he);
+	} while (he != fe2 && he != fe1 && he != NULL);
+	return he == fe2 ? steps : -1;
+}
+
 void CToolMesh::splitFace(VertexHandle v1, VertexHandle v2) {
 	topology_assert(!vertexEdge(v1, v2), { v1,v2 });
 	// find the face that contains v1 and v2
@@ -65,7 +87,7 @@ void CToolMesh::splitFace(VertexHandle v1, VertexHandle v2) {
 
 int CToolMesh::deleteVertexMergeFace(VertexHandle tar)
 {
-	assert(m_map_vert.find(tar->getId()) != m_map_vert.end());
+	assert(m_map_vert.find(tar->getId()) != NULL);
 	if (!vertexHalfedge(tar)) {
 		deleteVertex(tar);
 		return 0;
@@ -247,8 +269,8 @@ int CToolMesh::deleteEdgeMergeFace(EdgeHandle tar)
 	if (halfedgeFace(edgeHalfedge(tar, 1))) {
 		deleteFace(halfedgeFace(edgeHalfedge(tar, 1)));
 	}
-	topology_assert(!isSideEdge(edgeHalfedge(tar, 0)), { tar, edgeHalfedge(tar, 0)->feReference });
-	topology_assert(!isSideEdge(edgeHalfedge(tar, 1)), { tar, edgeHalfedge(tar, 1)->feReference });
+	topology_assert(!isSideEdge(edgeHalfedge(tar, 0)), { tar, getFeReference(edgeHalfedge(tar, 0)) });
+	topology_assert(!isSideEdge(edgeHalfedge(tar, 1)), { tar, getFeReference(edgeHalfedge(tar, 1)) });
 	setFace(edgeHalfedge(tar, 0), NULL);
 	setFace(edgeHalfedge(tar, 1), NULL);
 	unsetHalfedge(halfedgeVertex(edgeHalfedge(tar, 0)), edgeHalfedge(tar, 0));
@@ -364,36 +386,23 @@ int CToolMesh::numQuad(EdgeHandle edge)
 	return num;
 }
 
+// counters are maintained by createFace & deleteFace
 int CToolMesh::numTriangles(VertexHandle vert) {
 	assert(vert != NULL);
-	int num = 0;
-	for (VertexFaceIter vfiter(this, vert); !vfiter.end(); ++vfiter) {
-		if (!isQuad(*vfiter))
-			num++;
-	}
-	return num;
+	return vert->faceCount() - vert->quadCount();
 }
 
 int CToolMesh::numQuad(VertexHandle vert)
 {
 	assert(vert != NULL);
-	int num = 0;
-	for (VertexFaceIter vfiter(this, vert); !vfiter.end(); ++vfiter) {
-		if (isQuad(*vfiter))
-			num++;
-	}
-	return num;
+	return vert->quadCount();
 }
 
 
 bool CToolMesh::isQuad(FaceHandle face)
 {
 	assert(face);
-	int vertNum = 0;
-	for (FaceVertexIter fviter(face); !fviter.end(); ++fviter) {
-		vertNum++;
-	}
-	return vertNum == 4;
+	return face->degree() == 4;
 }
 
 void CToolMesh::unsetHalfedge(VertexHandle v, HalfedgeHandle he) {
@@ -411,24 +420,80 @@ void CToolMesh::unsetHalfedge(VertexHandle v, HalfedgeHandle he) {
 	}
 }
 
+void CToolMesh::crossFieldComputed() {
+	crossFieldReady = true;
+	crossFieldStale.clear();
+	buildCrossFieldTables();
+}
+
+void CToolMesh::clearCrossField() {
+	for (FaceIter fIter(this); !fIter.end(); fIter++) {
+		(*fIter)->crossFieldDirection.clear();
+	}
+	crossFieldReady = false;
+	crossFieldStale.clear();
+	vertexCrossFieldTable.clear();
+	edgeCrossFieldTable.clear();
+}
+
+void CToolMesh::buildCrossFieldTables() {
+	vertexCrossFieldTable.clear();
+	edgeCrossFieldTable.clear();
+	vertexCrossFieldTable.reserve(numVertices());
+	edgeCrossFieldTable.reserve(numEdges());
+	for (EdgeIter eIter(this); !eIter.end(); eIter++) {
+		computeEdgeCrossField(*eIter);
+	}
+	for (VertexIter vIter(this); !vIter.end(); vIter++) {
+		computeVertexCrossField(*vIter);
+	}
+}
+
+void CToolMesh::invalidateCrossFieldTables(FaceHandle face) {
+	for (FaceHalfedgeIter fhIter(face); !fhIter.end(); fhIter++) {
+		vertexCrossFieldTable.erase(halfedgeTarget(*fhIter));
+		edgeCrossFieldTable.erase(halfedgeEdge(*fhIter));
+	}
+}
+
 CPoint CToolMesh::edgeCrossField(EdgeHandle edge, int id) {
+	const CToolCrossFieldDirections* entry = edgeCrossFieldTable.find(edge);
+	return (entry ? *entry : computeEdgeCrossField(edge)).direction[id];
+}
+
+CPoint CToolMesh::vertexCrossField(VertexHandle vertex, int id) {
+	const CToolCrossFieldDirections* entry = vertexCrossFieldTable.find(vertex);
+	return (entry ? *entry : computeVertexCrossField(vertex)).direction[id];
+}
+
+const CToolCrossFieldDirections& CToolMesh::computeEdgeCrossField(EdgeHandle edge) {
+	CToolCrossFieldDirections& entry = edgeCrossFieldTable.ref(edge);
 	if (isBoundary(edge)) {
-		return edgeFace1(edge)->crossFieldDirection[id];
+		for (int id = 0; id < 4; id++) {
+			entry.direction[id] = edgeFace1(edge)->crossFieldDirection[id];
+		}
+		return entry;
 	}
 	HalfedgeHandle he1 = edgeHalfedge(edge, 0);
-	CPoint crossFieldVec1 = halfedgeFace(he1)->crossFieldDirection[id];
-	CPoint crossFieldVec2 = halfedgeFace(halfedgeSym(he1))->crossFieldDirection[(id + he1->crossFieldMatching)%4];
-	CPoint edgeCrossFieldVec = crossFieldVec1 + crossFieldVec2;
-	edgeCrossFieldVec = edgeCrossFieldVec / edgeCrossFieldVec.norm();
-	return edgeCrossFieldVec;
+	std::vector<CPoint>& directions1 = halfedgeFace(he1)->crossFieldDirection;
+	std::vector<CPoint>& directions2 = halfedgeFace(halfedgeSym(he1))->crossFieldDirection;
+	for (int id = 0; id < 4; id++) {
+		CPoint edgeCrossFieldVec = directions1[id] + directions2[(id + he1->crossFieldMatching) % 4];
+		entry.direction[id] = edgeCrossFieldVec / edgeCrossFieldVec.norm();
+	}
+	return entry;
 }
 
-CPoint CToolMesh::vertexCrossField(VertexHandle vertex, int id) {
+// all four directions in one walk around the vertex
+const CToolCrossFieldDirections& CToolMesh::computeVertexCrossField(VertexHandle vertex) {
+	CToolCrossFieldDirections& entry = vertexCrossFieldTable.ref(vertex);
+	CPoint* vertexCrossFieldVec = entry.direction;
+	for (int id = 0; id < 4; id++) {
+		vertexCrossFieldVec[id] = CPoint(0, 0, 0);
+	}
 	if (vertex->isSingular) {
-		return CPoint(0,0,0);
+		return entry;
 	}
-	int rotationIndex = id;
-	CPoint vertexCrossFieldVec(0, 0, 0);
 	if (isBoundary(vertex)) {
 		for (VertexIHalfedgeIter vhIter(this, vertex); !vhIter.end(); vhIter++) {
 			if (isBoundary(*vhIter)) {
@@ -440,19 +505,27 @@ CPoint CToolMesh::vertexCrossField(VertexHandle vertex, int id) {
 					}
 					rotationIndex += halfedgePrev(he)->crossFieldMatching;
 				} while (he = halfedgeSym(halfedgePrev(he)), !isBoundary(he));
-				vertexCrossFieldVec += halfedgeFace(halfedgeSym(*vhIter))->crossFieldDirection[id];
-				vertexCrossFieldVec += halfedgeFace(halfedgeSym(halfedgeNext(*vhIter)))->crossFieldDirection[(id+rotationIndex)%4];
-				vertexCrossFieldVec /= vertexCrossFieldVec.norm();
-				return vertexCrossFieldVec;
+				for (int id = 0; id < 4; id++) {
+					vertexCrossFieldVec[id] += halfedgeFace(halfedgeSym(*vhIter))->crossFieldDirection[id];
+					vertexCrossFieldVec[id] += halfedgeFace(halfedgeSym(halfedgeNext(*vhIter)))->crossFieldDirection[(id + rotationIndex) % 4];
+					vertexCrossFieldVec[id] /= vertexCrossFieldVec[id].norm();
+				}
+				return entry;
 			}
 		}
 	}
+	int rotationIndex = 0;
 	for (VertexIHalfedgeIter vihIter(this, vertex); !vihIter.end(); vihIter++) {
-		vertexCrossFieldVec += halfedgeFace(*vihIter)->crossFieldDirection[rotationIndex % 4];
+		std::vector<CPoint>& directions = halfedgeFace(*vihIter)->crossFieldDirection;
+		for (int id = 0; id < 4; id++) {
+			vertexCrossFieldVec[id] += directions[(id + rotationIndex) % 4];
+		}
 		rotationIndex += halfedgeNext(*vihIter)->crossFieldMatching;
 	}
-	vertexCrossFieldVec /= vertexCrossFieldVec.norm();
-	return vertexCrossFieldVec;
+	for (int id = 0; id < 4; id++) {
+		vertexCrossFieldVec[id] /= vertexCrossFieldVec[id].norm();
+	}
+	return entry;
 }
 
 CPoint CToolMesh::nearestCrossField(VertexHandle vertex, CPoint localDirection, int& index) {
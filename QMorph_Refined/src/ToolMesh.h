@@ -4,17 +4,23 @@
 #define _TOOL_MESH_H_
 
 #include<map>
+#include<unordered_map>
 #include<vector>
 #include<queue>
 #include<sstream>
 #include <initializer_list>
+#include <memory>
+#include <atomic>
+#include <stdint.h>
 #include <Mesh/BaseMesh.h>
 #include <Mesh/Edge.h>
 #include <Mesh/Face.h>
 #include <Mesh/HalfEdge.h>
 #include <Mesh/Vertex.h>
 #include <Mesh/iterators.h>
+#include <Mesh/Property.h>
 #include <Geometry/Point.h>
+#include "FrontSequence.h"
 #ifdef _DEBUG
 #include <DebuggerConnector.h>
 #endif
@@ -30,77 +36,59 @@ const double constAngle = 135.0;
 
 using namespace MeshLib;
 
-// definition of interface Component
+class CToolVertex;
+class CToolEdge;
+class CToolHalfedge;
+class CrossFieldSolver;
+
+// reference to a vertex, edge or halfedge passed to the debug output
 class Component {
 public:
-	virtual Component* getPointer() {
-		return this;
-	}
+	enum Type { VERTEX, EDGE, HALFEDGE };
+	Component(CToolVertex* v) : type(VERTEX), pointer(v) {}
+	Component(CToolEdge* e) : type(EDGE), pointer(e) {}
+	Component(CToolHalfedge* he) : type(HALFEDGE), pointer(he) {}
+	Type type;
+	void* pointer;
 };
 
-class CToolVertex : public CVertex, public Component {
+class CToolVertex : public CVertex {
 public:
 	int frontNum = 0;
 	bool isSide = false;
 	int sideNum = 0;
 	bool markDelete = false;
 	bool isSingular = false;
+	// counted by CToolChangedVertices as an interior vertex
+	bool countedInterior = false;
+	// geometry stamp of the mesh when the vertex last moved or got a new face
+	uint64_t geometryStamp = 0;
+	// front angle between frontAngleIn and frontAngleOut, valid while none of the
+	// vertices it is measured from has a newer geometry stamp
+	double frontAngle = 0;
+	CToolHalfedge* frontAngleIn = NULL;
+	CToolHalfedge* frontAngleOut = NULL;
+	uint64_t frontAngleStamp = 0;
+	// block of the vertex in the coloring smoothColorPass of the Smoother
+	int smoothBlock = -1;
+	int smoothColorPass = -1;
 	~CToolVertex()
 	{
 	}
-
-	virtual CToolVertex* getPointer() {
-		return this;
-	}
 };
 
-class CToolEdge : public CEdge, public Component {
+class CToolEdge : public CEdge {
 public:
 	bool disconnected = false;
 	~CToolEdge()
 	{
 	}
-
-	virtual CToolEdge* getPointer() {
-		return this;
-	}
 };
 
-class CToolHalfedge : public CHalfEdge, public Component {
+// the front state is kept by CToolMesh in a side table, see CToolFrontAttribute
+class CToolHalfedge : public CHalfEdge {
 public:
-	bool isFront = false;
-	int classNum = -1;
-	bool needTopEdge = true;
-	bool isSideEdge = false;
-	CToolHalfedge* prevFe = NULL;
-	CToolHalfedge* nextFe = NULL;
-	CToolHalfedge* leftSide = NULL;
-	CToolHalfedge* rightSide = NULL;
-	CToolHalfedge* topEdge = NULL;
-	CToolHalfedge* feReference = NULL;
-
 	int crossFieldMatching = 100; //ccw from current face to sym face
-	
-	~CToolHalfedge()
-	{
-		assert(!isSideEdge);
-	}
-	void attributeCopyTo(CToolHalfedge* he) {
-		he->isFront = isFront;
-		he->classNum = classNum;
-		he->needTopEdge = needTopEdge;
-		he->isSideEdge = isSideEdge;
-		he->prevFe = prevFe;
-		he->nextFe = nextFe;
-		he->leftSide = leftSide;
-		he->rightSide = rightSide;
-		he->topEdge = topEdge;
-		he->feReference = feReference;
-	}
-
-	virtual CToolHalfedge* getPointer() {
-		return this;
-	}
 };
 
 class CToolFace : public CFace {
@@ -115,6 +103,74 @@ typedef CToolHalfedge* HalfedgeHandle;
 typedef CToolFace* FaceHandle;
 typedef CPoint Point;
 
+// the four cross field directions at a vertex or an edge, see CToolMesh::vertexCrossField
+struct CToolCrossFieldDirections {
+	CPoint direction[4];
+};
+
+// state of a halfedge on the front or on the side of a quad under construction
+struct CToolFrontAttribute {
+	bool isFront = false;
+	int classNum = -1;
+	bool needTopEdge = true;
+	bool isSideEdge = false;
+	HalfedgeHandle prevFe = NULL;
+	HalfedgeHandle nextFe = NULL;
+	HalfedgeHandle leftSide = NULL;
+	HalfedgeHandle rightSide = NULL;
+	HalfedgeHandle topEdge = NULL;
+	HalfedgeHandle feReference = NULL;
+};
+
+// the vertices moved or given a new face since the last take(), in the order of
+// their first change. A deleted vertex drops out, and leaves the running count of
+// interior vertices if it was counted there.
+class CToolChangedVertices : public CPropertyBase<CToolVertex>
+{
+public:
+	void push(CToolVertex* v) {
+		if (index.insert(std::make_pair(v, changed.size())).second) {
+			changed.push_back(v);
+		}
+	}
+	// the changed vertices still in the mesh, the list starts empty again
+	std::vector<CToolVertex*> take() {
+		std::vector<CToolVertex*> result;
+		result.reserve(index.size());
+		for (CToolVertex* v : changed) {
+			if (v) {
+				result.push_back(v);
+			}
+		}
+		changed.clear();
+		index.clear();
+		return result;
+	}
+	void erase(const CToolVertex* v) override {
+		if (v->countedInterior) {
+			interior--;
+		}
+		std::unordered_map<const CToolVertex*, size_t>::iterator it = index.find(v);
+		if (it != index.end()) {
+			changed[it->second] = NULL;
+			index.erase(it);
+		}
+	}
+	void clear() override {
+		changed.clear();
+		index.clear();
+		interior = 0;
+	}
+	size_t size() const override {
+		return index.size();
+	}
+	int interior = 0;
+	bool counting = false;
+private:
+	std::vector<CToolVertex*> changed;
+	std::unordered_map<const CToolVertex*, size_t> index;
+};
+
 class CToolMesh : public CBaseMesh<CToolVertex,CToolEdge,CToolFace,CToolHalfedge>
 {
 public:
@@ -174,9 +230,9 @@ public:
 	void highlightVertexCrossField();
 	//void highlight(initializer_list<HalfedgeHandle> heList);
 	//void highlight(initializer_list<VertexHandle> vertList);
-	void highlight(initializer_list<Component*> componentList);
+	void highlight(initializer_list<Component> componentList);
 	void highlight(CPoint point);
-	void topology_assert(bool expr, initializer_list<Component*> componentList = initializer_list<Component*>());
+	void topology_assert(bool expr, initializer_list<Component> componentList = initializer_list<Component>());
 	void updateDebug();
 	
 	// getter & setters definitions
@@ -195,6 +251,19 @@ public:
 	void setPrevFe(HalfedgeHandle fe, HalfedgeHandle prev);
 	HalfedgeHandle getNextFe(HalfedgeHandle he);
 	void setNextFe(HalfedgeHandle fe, HalfedgeHandle next);
+	// angle(fe, next), cached at the vertex between them
+	double frontAngle(HalfedgeHandle fe, HalfedgeHandle next);
+	// class bits of fe and next from the angle between them, as setNextFe sets them
+	void classifyFront(HalfedgeHandle fe, HalfedgeHandle next);
+	// collect the vertices moved or given a new face while on. The first call counts
+	// the interior vertices, later ones keep the count from the changed vertices
+	void trackGeometryChanges(bool on);
+	// the vertices changed since the last call, their interior count brought up to date
+	std::vector<VertexHandle> takeChangedVertices();
+	// interior vertices, kept while the changes are tracked
+	int numInteriorVertices() const {
+		return changedVertices.interior;
+	}
 	HalfedgeHandle getLeftSide(HalfedgeHandle he);
 	HalfedgeHandle getRightSide(HalfedgeHandle he);
 protected:
@@ -206,6 +275,9 @@ public:
 	bool getNeedTopEdge(HalfedgeHandle he);
 	void setNeedTopEdge(HalfedgeHandle he, bool need);
 	int getClass(HalfedgeHandle he);
+	// whole front state of a halfedge, to carry it over when the halfedge is rebuilt
+	const CToolFrontAttribute& getFrontAttribute(HalfedgeHandle he) const;
+	void setFrontAttribute(HalfedgeHandle he, const CToolFrontAttribute& attr);
 	void buildQuad(HalfedgeHandle left, HalfedgeHandle bottom, HalfedgeHandle right, HalfedgeHandle top) {
 		clearFace({ left,bottom,right,top });
 	}
@@ -218,16 +290,38 @@ public:
 
 	CToolMesh();
 	int faceEdges(FaceHandle face) {
-		int count = 0;
-		for (FaceHalfedgeIter fiter(face); !fiter.end(); ++fiter) {
-			count++;
-		}
-		return count;
+		return face->degree();
 	}
 
 	void calculateCrossField();
+	// libdirectional's polyvector field, the in-tree solver of CrossFieldSolver.h,
+	// or the in-tree solver on a decimated copy, see ToolMeshProxyCrossField.cpp
+	enum CrossFieldMethod { CROSSFIELD_DIRECTIONAL, CROSSFIELD_BUILTIN, CROSSFIELD_PROXY };
+	CrossFieldMethod crossFieldMethod = CROSSFIELD_DIRECTIONAL;
+	// faces of the decimated copy, smaller meshes are solved directly
+	int proxyFaces = 20000;
+	// conjugate gradient iterations on the full mesh after the prolongation, 0 for none
+	int proxyRefineIterations = 30;
+	// the in-tree solver, kept with the mesh so its factorization is reused
+	CrossFieldSolver& crossFieldSolver();
+	// fill in the cross field of the faces created since the last solve or update,
+	// from their neighbours, and redo the matchings and singularities around them
+	void updateCrossField();
+	// whether the faces carry a cross field, computed or loaded from a .qmb file
+	bool hasCrossField() const {
+		return crossFieldReady;
+	}
+
+	// native binary mesh, see ToolMeshBinary.cpp. Loads into an empty mesh and
+	// keeps the element order of the file, reorderOnLoad() does not apply. A file
+	// truncated in any section, the attributes included, fails the read.
+	enum BinarySection { BINARY_CROSSFIELD = 1, BINARY_FRONT = 2 };
+	bool read_qmb(const char* input);
+	bool write_qmb(const char* output, int sections = BINARY_CROSSFIELD | BINARY_FRONT);
 
 	int frontEdgeSize(HalfedgeHandle fe);
+	// steps along nextFe from fe1 to fe2, at least one, -1 if fe2 is not on the loop of fe1
+	int frontEdgeSteps(HalfedgeHandle fe1, HalfedgeHandle fe2);
 
 	void splitFace(VertexHandle v1, VertexHandle v2);
 	
@@ -255,20 +349,13 @@ public:
 	void disconnect(EdgeHandle edge1);
 	bool isDisconnected(EdgeHandle edge);
 	void unsetHalfedge(VertexHandle v, HalfedgeHandle he);
-	std::vector<FaceHandle> objIdFaceMap;
-	std::vector<VertexHandle> objIdVertexMap;
-	void write_obj_set_map(string filename) {
-		for (FaceIter fIter(this); !fIter.end(); fIter++) {
-			objIdFaceMap.push_back(*fIter);
-		}
-		for (VertexIter vIter(this); !vIter.end(); vIter++) {
-			objIdVertexMap.push_back(*vIter);
-		}
-		this->write_obj(filename.c_str());
-	}
 
+	// read from the per-edge and per-vertex tables, an entry is computed again
+	// after the field or the faces around it changed
 	CPoint edgeCrossField(EdgeHandle edge, int id);
 	CPoint vertexCrossField(VertexHandle vertex, int id);
+	// fill the tables of all edges and vertices
+	void buildCrossFieldTables();
 	CPoint nearestCrossField(VertexHandle vertex, CPoint direction, int& index);
 
 	void alignToCrossField(EdgeHandle edge, VertexHandle pivotVertex);
@@ -276,6 +363,57 @@ public:
 protected:
 	int nextVid = 0;
 	int nextFid = 0;
+	bool crossFieldReady = false;
+	std::shared_ptr<CrossFieldSolver> builtinCrossFieldSolver;
+	// a new field on all faces, drops the stale marks and every table entry
+	void crossFieldComputed();
+	bool calculateProxyCrossField();
+	// directions of the vertices and edges, an element without an entry is computed
+	// on its next lookup. Sized by crossFieldComputed(), empty without a field
+	CSparseProperty<CToolVertex, CToolCrossFieldDirections> vertexCrossFieldTable;
+	CSparseProperty<CToolEdge, CToolCrossFieldDirections> edgeCrossFieldTable;
+	const CToolCrossFieldDirections& computeEdgeCrossField(EdgeHandle edge);
+	const CToolCrossFieldDirections& computeVertexCrossField(VertexHandle vertex);
+	// drop the table entries of the vertices and edges of the face
+	void invalidateCrossFieldTables(FaceHandle face);
+	// drop the field and its tables, after a failed load
+	void clearCrossField();
+	// faces created after the cross field was computed
+	CSparseProperty<CToolFace, bool> crossFieldStale;
+	FaceHandle markCrossFieldStale(FaceHandle face) {
+		invalidateCrossFieldTables(face);
+		if (crossFieldReady) {
+			crossFieldStale.set(face, true);
+		}
+		return face;
+	}
+	// raised for every vertex moved or given a new face, see frontAngle. Atomic,
+	// the parallel smoothing moves vertices from several threads. 64 bits, each
+	// front iteration raises it several times per vertex of the domain
+	std::atomic<uint64_t> geometryStamp{ 0 };
+	FaceHandle markGeometryChanged(FaceHandle face);
+	// filled by setPoint and markGeometryChanged while trackingChanges is set, off
+	// during the smoothing, whose threads must not push
+	CToolChangedVertices changedVertices;
+	bool trackingChanges = false;
+	FaceHandle createFace(VertexHandle v1, VertexHandle v2, VertexHandle v3) {
+		return markGeometryChanged(markCrossFieldStale(CBaseMesh::createFace(v1, v2, v3)));
+	}
+	FaceHandle createFace(VertexHandle v1, VertexHandle v2, VertexHandle v3, VertexHandle v4) {
+		return markGeometryChanged(markCrossFieldStale(CBaseMesh::createFace(v1, v2, v3, v4)));
+	}
+	FaceHandle createFace(std::vector<VertexHandle>& v, int id = -1) {
+		return markGeometryChanged(markCrossFieldStale(CBaseMesh::createFace(v, id)));
+	}
+	// front state of the halfedges which have been on a front or a side
+	CSparseProperty<CToolHalfedge, CToolFrontAttribute> frontAttribute;
+	// the nextFe links of the front edges as sequences, for the loop sizes
+	FrontSequence frontSequence;
+	// a side edge must be released by its front edge before the edge is deleted
+	void deleteEdge(EdgeHandle edge) {
+		assert(!isSideEdge(edgeHalfedge(edge, 0)) && !isSideEdge(edgeHalfedge(edge, 1)));
+		CBaseMesh::deleteEdge(edge);
+	}
 #ifdef _DEBUG
 	DebuggerConnector debug;
 #endif
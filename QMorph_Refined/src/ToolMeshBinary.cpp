@@ -0,0 +1,444 @@
+#include "ToolMesh.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <Parser/MappedFile.h>
+#include <Parser/MeshParser.h>
+#include <Parser/BufferedWriter.h>
+
+// Begin: binary mesh
+//
+// A .qmb file is a header followed by flat arrays, all little endian:
+//
+//   header     magic "QMB\0", version, sections, reserved, nv, ne, nf, nc
+//   vertices   int32 id[nv], double point[nv][3]
+//   faces      int32 id[nf], uint32 degree[nf], uint32 cornerVertex[nc]
+//   edges      uint32 edgeHalfedge[ne], int32 vertexHalfedge[nv]
+//   crossfield uint32 directionCount[nf], double direction[][3],
+//              int32 matching[2 * ne], uint8 singular[nv]
+//   front      int32 frontNum[nv], int32 sideNum[nv], uint8 isSide[nv],
+//              uint8 markDelete[nv], uint8 disconnected[ne],
+//              uint64 count, count front attribute records
+//
+// Corner c of a face is the halfedge from cornerVertex[c] to the next corner,
+// the last corner is the halfedge of the face. The edges are listed in the
+// order of the mesh, edgeHalfedge is the first halfedge of each edge given as
+// 2 * c for the halfedge of corner c and 2 * c + 1 for its sym. Everywhere
+// else a halfedge is 2 * e + i, the i-th halfedge of the e-th edge, -1 for none.
+
+namespace {
+	const char binaryMagic[4] = { 'Q', 'M', 'B', '\0' };
+	const uint32_t binaryVersion = 1;
+
+	struct CBinaryHeader {
+		char magic[4];
+		uint32_t version;
+		uint32_t sections;
+		uint32_t reserved;
+		uint64_t nv, ne, nf, nc;
+	};
+
+	class CBinaryWriter {
+	public:
+		CBinaryWriter(CBufferedWriter& os) : os(os) {}
+		template<typename T> void put(const T& value) {
+			os.write((const char*)&value, sizeof(T));
+		}
+		void putPoint(const CPoint& p) {
+			put(p[0]); put(p[1]); put(p[2]);
+		}
+	private:
+		CBufferedWriter& os;
+	};
+
+	// reads the mapped file in place, every read is checked against the end
+	class CBinaryReader {
+	public:
+		CBinaryReader(const char* data, size_t size) : cur(data), end(data + size) {}
+		template<typename T> bool get(T& value) {
+			return getArray(&value, 1);
+		}
+		template<typename T> bool getArray(T* values, size_t n) {
+			if (n > (size_t)(end - cur) / sizeof(T)) {
+				return false;
+			}
+			memcpy(values, cur, n * sizeof(T));
+			cur += n * sizeof(T);
+			return true;
+		}
+		bool getPoint(CPoint& p) {
+			return get(p[0]) && get(p[1]) && get(p[2]);
+		}
+	private:
+		const char* cur;
+		const char* end;
+	};
+}
+
+bool CToolMesh::write_qmb(const char* output, int sections) {
+	if (!crossFieldReady) {
+		sections &= ~BINARY_CROSSFIELD;
+	}
+
+	// index of every vertex and edge, and the corner of every halfedge of a face
+	std::unordered_map<const CToolVertex*, int32_t> vertexIndex;
+	std::unordered_map<const CToolHalfedge*, uint32_t> cornerIndex;
+	std::unordered_map<const CToolHalfedge*, int32_t> halfedgeIndex;
+	std::vector<VertexHandle> verts;
+	std::vector<EdgeHandle> edges;
+	std::vector<FaceHandle> faces;
+	for (VertexIter vIter(this); !vIter.end(); vIter++) {
+		vertexIndex[*vIter] = (int32_t)verts.size();
+		verts.push_back(*vIter);
+	}
+	for (EdgeIter eIter(this); !eIter.end(); eIter++) {
+		for (int i = 0; i < 2; i++) {
+			halfedgeIndex[edgeHalfedge(*eIter, i)] = (int32_t)(2 * edges.size() + i);
+		}
+		edges.push_back(*eIter);
+	}
+	for (FaceIter fIter(this); !fIter.end(); fIter++) {
+		faces.push_back(*fIter);
+	}
+
+	CBufferedWriter os;
+	if (!os.open(output, true)) {
+		cerr << "write_qmb: cannot open " << output << endl;
+		return false;
+	}
+	CBinaryWriter w(os);
+	CBinaryHeader header;
+	memcpy(header.magic, binaryMagic, 4);
+	header.version = binaryVersion;
+	header.sections = (uint32_t)sections;
+	header.reserved = 0;
+	header.nv = verts.size();
+	header.ne = edges.size();
+	header.nf = faces.size();
+	header.nc = 0;
+	for (size_t i = 0; i < faces.size(); i++) {
+		header.nc += faces[i]->degree();
+	}
+	w.put(header);
+
+	for (size_t i = 0; i < verts.size(); i++) {
+		w.put((int32_t)verts[i]->getId());
+	}
+	for (size_t i = 0; i < verts.size(); i++) {
+		w.putPoint(verts[i]->point());
+	}
+
+	for (size_t i = 0; i < faces.size(); i++) {
+		w.put((int32_t)faces[i]->id());
+	}
+	for (size_t i = 0; i < faces.size(); i++) {
+		w.put((uint32_t)faces[i]->degree());
+	}
+	uint32_t corner = 0;
+	for (size_t i = 0; i < faces.size(); i++) {
+		// start after the face halfedge, so it comes back as the last corner
+		HalfedgeHandle fh = faceHalfedge(faces[i]);
+		HalfedgeHandle he = halfedgeNext(fh);
+		for (int j = 0; j < faces[i]->degree(); j++) {
+			w.put((uint32_t)vertexIndex[halfedgeSource(he)]);
+			cornerIndex[he] = corner++;
+			he = halfedgeNext(he);
+		}
+		if (he != halfedgeNext(fh)) {
+			cerr << "write_qmb: the degree of face " << faces[i]->id() << " does not match its halfedges" << endl;
+			os.close();
+			remove(output);
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < edges.size(); i++) {
+		HalfedgeHandle he = edgeHalfedge(edges[i], 0);
+		std::unordered_map<const CToolHalfedge*, uint32_t>::const_iterator it = cornerIndex.find(he);
+		if (it != cornerIndex.end()) {
+			w.put(2 * it->second);
+			continue;
+		}
+		it = cornerIndex.find(halfedgeSym(he));
+		if (it == cornerIndex.end()) {
+			cerr << "write_qmb: edge " << edgeVertex1(edges[i])->getId() << " " << edgeVertex2(edges[i])->getId() << " has no face" << endl;
+			os.close();
+			remove(output);
+			return false;
+		}
+		w.put(2 * it->second + 1);
+	}
+	for (size_t i = 0; i < verts.size(); i++) {
+		HalfedgeHandle he = vertexHalfedge(verts[i]);
+		w.put(he ? halfedgeIndex[he] : (int32_t)-1);
+	}
+
+	if (sections & BINARY_CROSSFIELD) {
+		for (size_t i = 0; i < faces.size(); i++) {
+			w.put((uint32_t)faces[i]->crossFieldDirection.size());
+		}
+		for (size_t i = 0; i < faces.size(); i++) {
+			for (size_t j = 0; j < faces[i]->crossFieldDirection.size(); j++) {
+				w.putPoint(faces[i]->crossFieldDirection[j]);
+			}
+		}
+		for (size_t i = 0; i < edges.size(); i++) {
+			w.put((int32_t)edgeHalfedge(edges[i], 0)->crossFieldMatching);
+			w.put((int32_t)edgeHalfedge(edges[i], 1)->crossFieldMatching);
+		}
+		for (size_t i = 0; i < verts.size(); i++) {
+			w.put((uint8_t)verts[i]->isSingular);
+		}
+	}
+
+	if (sections & BINARY_FRONT) {
+		for (size_t i = 0; i < verts.size(); i++) {
+			w.put((int32_t)verts[i]->frontNum);
+		}
+		for (size_t i = 0; i < verts.size(); i++) {
+			w.put((int32_t)verts[i]->sideNum);
+		}
+		for (size_t i = 0; i < verts.size(); i++) {
+			w.put((uint8_t)verts[i]->isSide);
+		}
+		for (size_t i = 0; i < verts.size(); i++) {
+			w.put((uint8_t)verts[i]->markDelete);
+		}
+		for (size_t i = 0; i < edges.size(); i++) {
+			w.put((uint8_t)edges[i]->disconnected);
+		}
+		// the halfedges in edge order, so the file does not depend on the hash order
+		std::vector<HalfedgeHandle> attributed;
+		for (size_t i = 0; i < edges.size(); i++) {
+			for (int j = 0; j < 2; j++) {
+				if (frontAttribute.has(edgeHalfedge(edges[i], j))) {
+					attributed.push_back(edgeHalfedge(edges[i], j));
+				}
+			}
+		}
+		auto index = [&](HalfedgeHandle he) {
+			if (he == NULL) {
+				return (int32_t)-1;
+			}
+			std::unordered_map<const CToolHalfedge*, int32_t>::const_iterator it = halfedgeIndex.find(he);
+			return it == halfedgeIndex.end() ? (int32_t)-1 : it->second;
+		};
+		w.put((uint64_t)attributed.size());
+		for (size_t i = 0; i < attributed.size(); i++) {
+			const CToolFrontAttribute& attr = frontAttribute.get(attributed[i]);
+			w.put(index(attributed[i]));
+			w.put((int32_t)attr.classNum);
+			w.put((uint8_t)attr.isFront);
+			w.put((uint8_t)attr.needTopEdge);
+			w.put((uint8_t)attr.isSideEdge);
+			w.put((uint8_t)0);
+			w.put(index(attr.prevFe));
+			w.put(index(attr.nextFe));
+			w.put(index(attr.leftSide));
+			w.put(index(attr.rightSide));
+			w.put(index(attr.topEdge));
+			w.put(index(attr.feReference));
+		}
+	}
+
+	if (!os.close()) {
+		cerr << "write_qmb: cannot write " << output << endl;
+		return false;
+	}
+	return true;
+}
+
+bool CToolMesh::read_qmb(const char* input) {
+	if (!m_verts.empty() || !m_faces.empty()) {
+		cerr << "read_qmb: the mesh must be empty" << endl;
+		return false;
+	}
+	CMappedFile file;
+	if (!file.open(input)) {
+		cerr << "read_qmb: cannot open " << input << endl;
+		return false;
+	}
+	CBinaryReader r(file.data(), file.size());
+	CBinaryHeader header;
+	if (!r.get(header) || memcmp(header.magic, binaryMagic, 4) != 0) {
+		cerr << "read_qmb: " << input << " is not a binary mesh" << endl;
+		return false;
+	}
+	if (header.version != binaryVersion) {
+		cerr << "read_qmb: " << input << " has version " << header.version << ", expected " << binaryVersion << endl;
+		return false;
+	}
+	// every element takes at least a byte, larger counts come from a corrupt header
+	if (header.nv > file.size() || header.ne > file.size() || header.nf > file.size() || header.nc > file.size()) {
+		cerr << "read_qmb: " << input << " is truncated" << endl;
+		return false;
+	}
+	size_t nv = (size_t)header.nv, ne = (size_t)header.ne, nf = (size_t)header.nf, nc = (size_t)header.nc;
+	bool ok = true;
+
+	CMeshRecords records;
+	records.vertexId.resize(nv);
+	records.vertexPoint.resize(nv);
+	records.vertexString.resize(nv);
+	ok = ok && r.getArray(records.vertexId.data(), nv);
+	for (size_t i = 0; ok && i < nv; i++) {
+		ok = r.getPoint(records.vertexPoint[i]);
+	}
+
+	records.faceId.resize(nf);
+	records.faceString.resize(nf);
+	std::vector<uint32_t> degree(nf);
+	std::vector<uint32_t> cornerVertex(nc);
+	ok = ok && r.getArray(records.faceId.data(), nf) && r.getArray(degree.data(), nf) && r.getArray(cornerVertex.data(), nc);
+	records.faceStart.resize(nf + 1);
+	for (size_t i = 0; ok && i < nf; i++) {
+		records.faceStart[i + 1] = records.faceStart[i] + degree[i];
+	}
+	ok = ok && records.faceStart[nf] == nc;
+	records.cornerVertex.resize(nc);
+	for (size_t c = 0; ok && c < nc; c++) {
+		ok = cornerVertex[c] < nv;
+		if (ok) records.cornerVertex[c] = records.vertexId[cornerVertex[c]];
+	}
+
+	std::vector<uint32_t> edgeHalfedgeIndex(ne);
+	std::vector<int32_t> vertexHalfedgeIndex(nv);
+	ok = ok && r.getArray(edgeHalfedgeIndex.data(), ne) && r.getArray(vertexHalfedgeIndex.data(), nv);
+	if (!ok) {
+		cerr << "read_qmb: " << input << " is truncated or corrupt" << endl;
+		return false;
+	}
+
+	if (!buildFromRecords(records)) {
+		return false;
+	}
+
+	// the lists hold the elements in the order of the records
+	std::vector<VertexHandle> verts;
+	std::vector<FaceHandle> faces;
+	verts.reserve(nv);
+	faces.reserve(nf);
+	for (VertexIter vIter(this); !vIter.end(); vIter++) {
+		verts.push_back(*vIter);
+	}
+	for (FaceIter fIter(this); !fIter.end(); fIter++) {
+		faces.push_back(*fIter);
+	}
+	std::vector<HalfedgeHandle> cornerHalfedge(nc);
+	for (size_t i = 0; i < nf; i++) {
+		HalfedgeHandle he = halfedgeNext(faceHalfedge(faces[i]));
+		for (size_t c = records.faceStart[i]; c < records.faceStart[i + 1]; c++) {
+			cornerHalfedge[c] = he;
+			he = halfedgeNext(he);
+		}
+	}
+
+	// restore the order and the orientation of the edges
+	std::vector<EdgeHandle> edges(ne);
+	ok = ne == m_edges.size();
+	for (size_t i = 0; ok && i < ne; i++) {
+		ok = edgeHalfedgeIndex[i] / 2 < nc;
+		if (!ok) break;
+		HalfedgeHandle he = cornerHalfedge[edgeHalfedgeIndex[i] / 2];
+		if (edgeHalfedgeIndex[i] % 2) {
+			he = halfedgeSym(he);
+		}
+		edges[i] = halfedgeEdge(he);
+		HalfedgeHandle sym = halfedgeSym(he);
+		setHalfedge(edges[i], 0, he);
+		setHalfedge(edges[i], 1, sym);
+	}
+	if (!ok) {
+		cerr << "read_qmb: the edges of " << input << " do not match its faces" << endl;
+		return false;
+	}
+	m_edges.reorder(edges);
+	auto halfedge = [&](int32_t index) {
+		return index < 0 || (size_t)index >= 2 * ne ? (HalfedgeHandle)NULL : edgeHalfedge(edges[index / 2], index % 2);
+	};
+
+	labelBoundary();
+	// the vertices without a halfedge are gone now, the others get theirs back
+	for (size_t i = 0; i < nv; i++) {
+		if (vertexHalfedgeIndex[i] >= 0) {
+			setHalfedge(verts[i], halfedge(vertexHalfedgeIndex[i]));
+		}
+	}
+
+	if (header.sections & BINARY_CROSSFIELD) {
+		std::vector<uint32_t> directionCount(nf);
+		ok = r.getArray(directionCount.data(), nf);
+		for (size_t i = 0; ok && i < nf; i++) {
+			faces[i]->crossFieldDirection.resize(directionCount[i]);
+			for (size_t j = 0; ok && j < directionCount[i]; j++) {
+				ok = r.getPoint(faces[i]->crossFieldDirection[j]);
+			}
+		}
+		std::vector<int32_t> matching(2 * ne);
+		std::vector<uint8_t> singular(nv);
+		ok = ok && r.getArray(matching.data(), 2 * ne) && r.getArray(singular.data(), nv);
+		for (size_t i = 0; ok && i < 2 * ne; i++) {
+			halfedge((int32_t)i)->crossFieldMatching = matching[i];
+		}
+		for (size_t i = 0; ok && i < nv; i++) {
+			if (vertexHalfedgeIndex[i] >= 0) verts[i]->isSingular = singular[i] != 0;
+		}
+		if (ok) {
+			crossFieldComputed();
+		}
+	}
+
+	if (ok && (header.sections & BINARY_FRONT)) {
+		std::vector<int32_t> frontNum(nv), sideNum(nv);
+		std::vector<uint8_t> isSide(nv), markDelete(nv), disconnected(ne);
+		ok = r.getArray(frontNum.data(), nv) && r.getArray(sideNum.data(), nv)
+			&& r.getArray(isSide.data(), nv) && r.getArray(markDelete.data(), nv)
+			&& r.getArray(disconnected.data(), ne);
+		for (size_t i = 0; ok && i < nv; i++) {
+			if (vertexHalfedgeIndex[i] < 0) continue;
+			verts[i]->frontNum = frontNum[i];
+			verts[i]->sideNum = sideNum[i];
+			verts[i]->isSide = isSide[i] != 0;
+			verts[i]->markDelete = markDelete[i] != 0;
+		}
+		for (size_t i = 0; ok && i < ne; i++) {
+			edges[i]->disconnected = disconnected[i] != 0;
+		}
+		uint64_t count = 0;
+		ok = ok && r.get(count);
+		for (uint64_t i = 0; ok && i < count; i++) {
+			int32_t he, classNum, link[6];
+			uint8_t flags[4];
+			ok = r.get(he) && r.get(classNum) && r.getArray(flags, 4) && r.getArray(link, 6) && halfedge(he) != NULL;
+			if (!ok) break;
+			CToolFrontAttribute& attr = frontAttribute.ref(halfedge(he));
+			attr.classNum = classNum;
+			attr.isFront = flags[0] != 0;
+			attr.needTopEdge = flags[1] != 0;
+			attr.isSideEdge = flags[2] != 0;
+			attr.prevFe = halfedge(link[0]);
+			attr.nextFe = halfedge(link[1]);
+			attr.leftSide = halfedge(link[2]);
+			attr.rightSide = halfedge(link[3]);
+			attr.topEdge = halfedge(link[4]);
+			attr.feReference = halfedge(link[5]);
+		}
+		for (CSparseProperty<CToolHalfedge, CToolFrontAttribute>::const_iterator it = frontAttribute.begin(); ok && it != frontAttribute.end(); ++it) {
+			if (it->second.isFront && it->second.nextFe != NULL) {
+				frontSequence.link(it->first, it->second.nextFe);
+			}
+		}
+	}
+	if (!ok) {
+		// a half restored field or front must not reach QMorph
+		clearCrossField();
+		frontAttribute.clear();
+		frontSequence.clear();
+		cerr << "read_qmb: the attributes of " << input << " are truncated" << endl;
+		return false;
+	}
+	return true;
+}
+
+// End binary mesh
@@ -1,8 +1,8 @@
 
 #include "ToolMesh.h"
+#include "CrossFieldSolver.h"
 #include <Eigen/Core>
-#include <directional/readOFF.h>
-#include <directional/readOBJ.h>
+#include <directional/TriMesh.h>
 #include <directional/polyvector_to_raw.h>
 #include <directional/polyvector_field.h>
 #include <directional/principal_matching.h>
@@ -12,15 +12,19 @@
 
 // Begin: CrossField
 
+// the solve of one call of calculateCrossField, the state is per instance so
+// several meshes can be solved at the same time
 class CrossField
 {
 public:
-	void setMesh(CTMesh* mesh) {
-		this->ct_mesh = mesh;
-	}
-	CTMesh* ct_mesh;
+	bool setMesh(CTMesh* mesh);
+	CTMesh* ct_mesh = nullptr;
 	int main();
 
+	// row i of the vertex and face matrices of the directional mesh
+	std::vector<VertexHandle> vertexMap;
+	std::vector<FaceHandle> faceMap;
+
 	Eigen::VectorXi constFaces;
 	directional::TriMesh mesh;
 	directional::IntrinsicFaceTangentBundle ftb;
@@ -33,18 +37,43 @@ public:
 	int N = 4;
 };
 
-typedef enum { CONSTRAINTS, HARD_PRESCRIPTION, SOFT_PRESCRIPTION } ViewingModes;
-ViewingModes viewingMode = CONSTRAINTS;
-
-bool alterRoSyWeight = false;
+// fill the directional mesh from the vertex and face lists, indexed in list order
+bool CrossField::setMesh(CTMesh* toolMesh) {
+	ct_mesh = toolMesh;
+	vertexMap.clear();
+	faceMap.clear();
+	vertexMap.reserve(toolMesh->numVertices());
+	faceMap.reserve(toolMesh->numFaces());
+	Eigen::MatrixXd V(toolMesh->numVertices(), 3);
+	Eigen::MatrixXi F(toolMesh->numFaces(), 3);
+	for (CTMesh::VertexIter vIter(toolMesh); !vIter.end(); vIter++) {
+		(*vIter)->fakeId = (int)vertexMap.size();
+		for (int i = 0; i < 3; i++) {
+			V(vertexMap.size(), i) = (*vIter)->point()[i];
+		}
+		vertexMap.push_back(*vIter);
+	}
+	for (CTMesh::FaceIter fIter(toolMesh); !fIter.end(); fIter++) {
+		if ((*fIter)->degree() != 3) {
+			cerr << "CrossField: face " << (*fIter)->id() << " is not a triangle" << endl;
+			return false;
+		}
+		// the corners in the order the .obj writer lists them
+		HalfedgeHandle he = toolMesh->faceHalfedge(*fIter);
+		for (int i = 0; i < 3; i++) {
+			F(faceMap.size(), i) = toolMesh->halfedgeTarget(he)->fakeId;
+			he = toolMesh->halfedgeNext(he);
+		}
+		faceMap.push_back(*fIter);
+	}
+	mesh.set_mesh(V, F);
+	return true;
+}
 
 int CrossField::main() {
 	if (ct_mesh == nullptr) {
 		assert(false);
 	}
-	// Load mesh
-	this->ct_mesh->write_obj_set_map("temp.obj");
-	directional::readOBJ("temp.obj", mesh);
 	ftb.init(mesh);
 	pvFieldHard.init(ftb, directional::fieldTypeEnum::POLYVECTOR_FIELD, N);
 
@@ -93,8 +122,8 @@ int CrossField::main() {
 	directional::polyvector_to_raw(pvFieldHard, rawFieldHard, true);
 	directional::principal_matching(rawFieldHard);
 	for (int vertexIndex = 0; vertexIndex < rawFieldHard.singLocalCycles.rows(); vertexIndex++) {
-		if (!ct_mesh->isBoundary(ct_mesh->objIdVertexMap[rawFieldHard.singLocalCycles(vertexIndex)])) {
-			ct_mesh->objIdVertexMap[rawFieldHard.singLocalCycles(vertexIndex)]->isSingular = true;
+		if (!ct_mesh->isBoundary(vertexMap[rawFieldHard.singLocalCycles(vertexIndex)])) {
+			vertexMap[rawFieldHard.singLocalCycles(vertexIndex)]->isSingular = true;
 		}
 	}
 
@@ -117,8 +146,8 @@ int CrossField::main() {
 				continue;
 			}
 			int matchingNumber = isFromFaceToAjacent ? rawFieldHard.matching(ajacentEdgeIndex) : (N - rawFieldHard.matching(ajacentEdgeIndex))%4;
-			FaceHandle curFace = ct_mesh->objIdFaceMap[faceIndex];
-			FaceHandle adjFace = ct_mesh->objIdFaceMap[ajacentFaceIndex];
+			FaceHandle curFace = faceMap[faceIndex];
+			FaceHandle adjFace = faceMap[ajacentFaceIndex];
 			for (CTMesh::FaceHalfedgeIter fhIter(curFace); !fhIter.end(); fhIter++) {
 				if (ct_mesh->halfedgeFace(ct_mesh->halfedgeSym(*fhIter))==adjFace) {
 					(*fhIter)->crossFieldMatching = matchingNumber;
@@ -126,7 +155,7 @@ int CrossField::main() {
 				}
 			}
 		}
-		ct_mesh->objIdFaceMap[faceIndex]->crossFieldDirection = crossFieldVector;
+		faceMap[faceIndex]->crossFieldDirection = crossFieldVector;
 	}
 
 
@@ -135,10 +164,27 @@ int CrossField::main() {
 
 // End CrossField
 
-CrossField cf;
-
 
 void CToolMesh::calculateCrossField() {
-	cf.setMesh(this);
+	if (crossFieldMethod == CROSSFIELD_PROXY) {
+		if (calculateProxyCrossField()) {
+			crossFieldComputed();
+		}
+		return;
+	}
+	if (crossFieldMethod == CROSSFIELD_BUILTIN) {
+		CrossFieldSolver& solver = crossFieldSolver();
+		solver.clearConstraints();
+		solver.addBoundaryConstraints();
+		if (solver.solve()) {
+			crossFieldComputed();
+		}
+		return;
+	}
+	CrossField cf;
+	if (!cf.setMesh(this)) {
+		return;
+	}
 	cf.main();
+	crossFieldComputed();
 }
\ No newline at end of file
@@ -92,7 +92,7 @@ void CToolMesh::highlight(HalfedgeHandle edge) {
 	highlight(halfedgeEdge(edge));
 }
 
-void CToolMesh::topology_assert(bool expr, initializer_list<Component*> componentList) {
+void CToolMesh::topology_assert(bool expr, initializer_list<Component> componentList) {
 	if (!expr) {
 		cout << "ERROR: Topology assert failed" << endl;
 		highlight(componentList);
@@ -101,16 +101,21 @@ void CToolMesh::topology_assert(bool expr, initializer_list<Component*> componen
 	}
 }
 
-void CToolMesh::highlight(initializer_list<Component*> componentList) {
-	for (Component* component : componentList) {
-		if (typeid(*component->getPointer()) == typeid(CToolEdge)) {
-			highlight((CToolEdge*)component);
+void CToolMesh::highlight(initializer_list<Component> componentList) {
+	for (const Component& component : componentList) {
+		if (!component.pointer) {
+			continue;
 		}
-		if (typeid(*component->getPointer()) == typeid(CToolHalfedge)) {
-			highlight((CToolHalfedge*)component);
-		}
-		if (typeid(*component->getPointer()) == typeid(CToolVertex)) {
-			highlight((CToolVertex*)component);
+		switch (component.type) {
+		case Component::EDGE:
+			highlight((EdgeHandle)component.pointer);
+			break;
+		case Component::HALFEDGE:
+			highlight((HalfedgeHandle)component.pointer);
+			break;
+		case Component::VERTEX:
+			highlight((VertexHandle)component.pointer);
+			break;
 		}
 	}
 }
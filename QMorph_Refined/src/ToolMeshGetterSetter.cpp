@@ -1,13 +1,14 @@
 #include"ToolMesh.h"
 
 void CToolMesh::setSideEdge(HalfedgeHandle side, HalfedgeHandle fe) {
+	CToolFrontAttribute& attr = frontAttribute.ref(side);
 	if (fe) {
-		side->isSideEdge = true;
-		side->feReference = fe;
+		attr.isSideEdge = true;
+		attr.feReference = fe;
 	}
 	else {
-		side->isSideEdge = false;
-		side->feReference = NULL;
+		attr.isSideEdge = false;
+		attr.feReference = NULL;
 	}
 }
 
@@ -23,11 +24,11 @@ void CToolMesh::setSide(HalfedgeHandle lfe, HalfedgeHandle rfe, HalfedgeHandle u
 }
 
 bool CToolMesh::isSideEdge(HalfedgeHandle he) {
-	return he->isSideEdge;
+	return frontAttribute.get(he).isSideEdge;
 }
 
 HalfedgeHandle CToolMesh::getFeReference(HalfedgeHandle he) {
-	return he->feReference;
+	return frontAttribute.get(he).feReference;
 }
 
 void CToolMesh::setPoint(VertexHandle v, const Point& p) {
@@ -36,6 +37,48 @@ void CToolMesh::setPoint(VertexHandle v, const Point& p) {
 		assert(false);
 	}
 	v->point() = p;
+	v->geometryStamp = ++geometryStamp;
+	if (trackingChanges) {
+		changedVertices.push(v);
+	}
+}
+
+// the new halfedges have no cached angles, the stamps keep a reused address from matching
+FaceHandle CToolMesh::markGeometryChanged(FaceHandle face) {
+	for (FaceVertexIter fvIter(face); !fvIter.end(); fvIter++) {
+		(*fvIter)->geometryStamp = ++geometryStamp;
+		if (trackingChanges) {
+			changedVertices.push(*fvIter);
+		}
+	}
+	return face;
+}
+
+void CToolMesh::trackGeometryChanges(bool on) {
+	trackingChanges = on;
+	if (!on || changedVertices.counting) {
+		return;
+	}
+	changedVertices.counting = true;
+	changedVertices.interior = 0;
+	for (VertexIter vIter(this); !vIter.end(); vIter++) {
+		(*vIter)->countedInterior = !isBoundary(*vIter);
+		changedVertices.interior += (*vIter)->countedInterior;
+	}
+}
+
+// a vertex turns interior or boundary only when a face around it is made, so only
+// the changed vertices are looked at again
+std::vector<VertexHandle> CToolMesh::takeChangedVertices() {
+	std::vector<VertexHandle> changed = changedVertices.take();
+	for (VertexHandle v : changed) {
+		bool interior = !isBoundary(v);
+		if (interior != v->countedInterior) {
+			changedVertices.interior += interior ? 1 : -1;
+			v->countedInterior = interior;
+		}
+	}
+	return changed;
 }
 
 const Point CToolMesh::getPoint(VertexHandle v) const {
@@ -43,50 +86,57 @@ const Point CToolMesh::getPoint(VertexHandle v) const {
 }
 
 bool CToolMesh::isFront(HalfedgeHandle he) {
-	return he->isFront;
+	return frontAttribute.get(he).isFront;
 }
 bool CToolMesh::isFront(VertexHandle v) {
 	return v->frontNum > 0;
 }
 
 int CToolMesh::getClass(HalfedgeHandle he) {
-	return he->classNum;
+	return frontAttribute.get(he).classNum;
 }
 void CToolMesh::setClass(HalfedgeHandle he, int cls) {
-	he->classNum = cls;
+	frontAttribute.ref(he).classNum = cls;
+}
+const CToolFrontAttribute& CToolMesh::getFrontAttribute(HalfedgeHandle he) const {
+	return frontAttribute.get(he);
+}
+void CToolMesh::setFrontAttribute(HalfedgeHandle he, const CToolFrontAttribute& attr) {
+	frontAttribute.set(he, attr);
+	// the links of the copy lead to the old halfedge, the loop is linked again
+	frontSequence.isolate(he);
 }
 HalfedgeHandle CToolMesh::getPrevFe(HalfedgeHandle he) {
-	return he->prevFe;
+	return frontAttribute.get(he).prevFe;
 }
 
 //setPrevFe
 void CToolMesh::setPrevFe(HalfedgeHandle fe, HalfedgeHandle prev) {
 	assert(isFront(fe));
 	assert(isFront(prev));
-	fe->prevFe = prev;
-	prev->nextFe = fe;
-	if (angle(prev, fe) < constAngle) {
-		setClass(fe, getClass(fe) | 2);
-		setClass(prev, getClass(prev) | 1);
-	}
-	else {
-		setClass(fe, getClass(fe) & 1);
-		setClass(prev, getClass(prev) & 2);
-	}
+	frontAttribute.ref(fe).prevFe = prev;
+	frontAttribute.ref(prev).nextFe = fe;
+	frontSequence.link(prev, fe);
+	classifyFront(prev, fe);
 }
 
 //getNextFe
 HalfedgeHandle CToolMesh::getNextFe(HalfedgeHandle he) {
-	return he->nextFe;
+	return frontAttribute.get(he).nextFe;
 }
 
 //setNextFe
 void CToolMesh::setNextFe(HalfedgeHandle fe, HalfedgeHandle next) {
 	assert(isFront(fe));
 	assert(isFront(next));
-	next->prevFe = fe;
-	fe->nextFe = next;
-	if (angle(fe, next) < constAngle) {
+	frontAttribute.ref(next).prevFe = fe;
+	frontAttribute.ref(fe).nextFe = next;
+	frontSequence.link(fe, next);
+	classifyFront(fe, next);
+}
+
+void CToolMesh::classifyFront(HalfedgeHandle fe, HalfedgeHandle next) {
+	if (frontAngle(fe, next) < constAngle) {
 		setClass(fe, getClass(fe) | 1);
 		setClass(next, getClass(next) | 2);
 	}
@@ -96,18 +146,32 @@ void CToolMesh::setNextFe(HalfedgeHandle fe, HalfedgeHandle next) {
 	}
 }
 
+double CToolMesh::frontAngle(HalfedgeHandle fe, HalfedgeHandle next) {
+	VertexHandle v = halfedgeTarget(fe);
+	// angle(fe, next) reads the three vertices of the face of fe and the target of next
+	uint64_t stamp = std::max(std::max(v->geometryStamp, halfedgeSource(fe)->geometryStamp),
+		std::max(halfedgeTarget(next)->geometryStamp, halfedgeTarget(halfedgeNext(fe))->geometryStamp));
+	if (v->frontAngleIn != fe || v->frontAngleOut != next || v->frontAngleStamp < stamp) {
+		v->frontAngle = angle(fe, next);
+		v->frontAngleIn = fe;
+		v->frontAngleOut = next;
+		v->frontAngleStamp = geometryStamp;
+	}
+	return v->frontAngle;
+}
+
 HalfedgeHandle CToolMesh::getLeftSide(HalfedgeHandle he) {
-	return he->leftSide;
+	return frontAttribute.get(he).leftSide;
 }
 HalfedgeHandle CToolMesh::getRightSide(HalfedgeHandle he) {
-	return he->rightSide;
+	return frontAttribute.get(he).rightSide;
 }
 void CToolMesh::setLeftSide(HalfedgeHandle he, HalfedgeHandle left) {
 	if (getLeftSide(he)) {
 		halfedgeSource(getLeftSide(he))->isSide = false;
 		setSideEdge(getLeftSide(he), NULL);
 	}
-	he->leftSide = left;
+	frontAttribute.ref(he).leftSide = left;
 	if (left) {
 		setSideEdge(left, he);
 		halfedgeTarget(left)->isSide = true;
@@ -119,7 +183,7 @@ void CToolMesh::setRightSide(HalfedgeHandle he, HalfedgeHandle right) {
 		halfedgeTarget(getRightSide(he))->isSide = false;
 		setSideEdge(getRightSide(he), NULL);
 	}
-	he->rightSide = right;
+	frontAttribute.ref(he).rightSide = right;
 	if (right) {
 		setSideEdge(right, he);
 		halfedgeTarget(right)->isSide = true;
@@ -128,18 +192,18 @@ void CToolMesh::setRightSide(HalfedgeHandle he, HalfedgeHandle right) {
 
 //get & set topEdge
 HalfedgeHandle CToolMesh::getTopEdge(HalfedgeHandle he) {
-	return he->topEdge;
+	return frontAttribute.get(he).topEdge;
 }
 void CToolMesh::setTopEdge(HalfedgeHandle he, HalfedgeHandle top) {
-	he->topEdge = top;
+	frontAttribute.ref(he).topEdge = top;
 }
 
 //get & set needTopEdge
 bool CToolMesh::getNeedTopEdge(HalfedgeHandle he) {
-	return he->needTopEdge;
+	return frontAttribute.get(he).needTopEdge;
 }
 void CToolMesh::setNeedTopEdge(HalfedgeHandle he, bool need) {
-	he->needTopEdge = need;
+	frontAttribute.ref(he).needTopEdge = need;
 }
 
 void CToolMesh::setFront(HalfedgeHandle fe, bool val)
@@ -149,7 +213,7 @@ void CToolMesh::setFront(HalfedgeHandle fe, bool val)
 			return;
 		}
 		setClass(fe, 0);
-		fe->isFront = true;
+		frontAttribute.ref(fe).isFront = true;
 		halfedgeSource(fe)->frontNum++;
 		halfedgeTarget(fe)->frontNum++;
 	}
@@ -159,7 +223,7 @@ void CToolMesh::setFront(HalfedgeHandle fe, bool val)
 		}
 		setClass(fe, -1);
 
-		fe->isFront = false;
+		frontAttribute.ref(fe).isFront = false;
 		halfedgeSource(fe)->frontNum--;
 		halfedgeTarget(fe)->frontNum--;
 		setLeftSide(fe, NULL);
@@ -0,0 +1,186 @@
+#include <OpenMesh/Core/Mesh/TriMesh_ArrayKernelT.hh>
+#include <OpenMesh/Tools/Decimater/DecimaterT.hh>
+#include <OpenMesh/Tools/Decimater/ModQuadricT.hh>
+#include <OpenMesh/Tools/Decimater/ModNormalFlippingT.hh>
+#include <OpenMesh/Tools/Decimater/ModAspectRatioT.hh>
+#include <math.h>
+#include <unordered_map>
+#include "ToolMesh.h"
+#include "CrossFieldSolver.h"
+
+// The field is smooth, so it is solved on a decimated copy of the mesh and
+// carried back: every vertex of the mesh takes the vertex it was collapsed into,
+// every face the mean of the crosses of those vertices. The boundary vertices are
+// locked, the copy has the same boundary and the boundary constraints hold.
+// A few conjugate gradient iterations on the full mesh then remove what the
+// coarse faces could not resolve, the matchings and singularities are computed
+// from the field on the full mesh.
+
+namespace {
+	struct ProxyTraits : public OpenMesh::DefaultTraits {
+		typedef OpenMesh::Vec3d Point;
+		typedef OpenMesh::Vec3d Normal;
+	};
+	typedef OpenMesh::TriMesh_ArrayKernelT<ProxyTraits> ProxyMesh;
+
+	// records for every collapse which vertex the removed one went into
+	template <typename MeshT>
+	class ModCollapseTrackT : public OpenMesh::Decimater::ModBaseT<MeshT>
+	{
+	public:
+		DECIMATING_MODULE(ModCollapseTrackT, MeshT, CollapseTrack);
+
+		ModCollapseTrackT(MeshT& _mesh) : Base(_mesh, true) {
+			parent.resize(_mesh.n_vertices(), -1);
+		}
+
+		void preprocess_collapse(const CollapseInfo& _ci) override {
+			parent[_ci.v0.idx()] = _ci.v1.idx();
+		}
+
+		// the vertex still in the mesh the vertex ended up in
+		int survivor(int v) {
+			int root = v;
+			while (parent[root] >= 0) {
+				root = parent[root];
+			}
+			while (parent[v] >= 0) {
+				int next = parent[v];
+				parent[v] = root;
+				v = next;
+			}
+			return root;
+		}
+
+		std::vector<int> parent;
+	};
+	typedef ModCollapseTrackT<ProxyMesh> ModCollapseTrack;
+}
+
+bool CToolMesh::calculateProxyCrossField() {
+	if (numFaces() <= proxyFaces) {
+		CrossFieldSolver& solver = crossFieldSolver();
+		solver.clearConstraints();
+		solver.addBoundaryConstraints();
+		return solver.solve();
+	}
+
+	ProxyMesh om;
+	std::vector<VertexHandle> verts;
+	std::unordered_map<VertexHandle, int> vertexIndex;
+	for (VertexIter vIter(this); !vIter.end(); vIter++) {
+		Point p = getPoint(*vIter);
+		vertexIndex[*vIter] = (int)verts.size();
+		verts.push_back(*vIter);
+		ProxyMesh::VertexHandle vh = om.add_vertex(ProxyMesh::Point(p[0], p[1], p[2]));
+		assert(vh.idx() == vertexIndex[*vIter]);
+	}
+	for (FaceIter fIter(this); !fIter.end(); fIter++) {
+		std::vector<ProxyMesh::VertexHandle> corners;
+		for (FaceVertexIter fvIter(*fIter); !fvIter.end(); fvIter++) {
+			corners.push_back(om.vertex_handle(vertexIndex[*fvIter]));
+		}
+		if (corners.size() != 3 || !om.add_face(corners).is_valid()) {
+			cerr << "calculateProxyCrossField: only manifold triangle meshes can be decimated" << endl;
+			return false;
+		}
+	}
+
+	om.request_vertex_status();
+	om.request_edge_status();
+	om.request_face_status();
+	om.request_face_normals();
+	om.update_face_normals();
+	for (ProxyMesh::VertexIter vIter = om.vertices_begin(); vIter != om.vertices_end(); ++vIter) {
+		if (om.is_boundary(*vIter)) {
+			om.status(*vIter).set_locked(true);
+		}
+	}
+
+	OpenMesh::Decimater::DecimaterT<ProxyMesh> decimater(om);
+	OpenMesh::Decimater::ModQuadricT<ProxyMesh>::Handle quadric;
+	OpenMesh::Decimater::ModNormalFlippingT<ProxyMesh>::Handle normalFlipping;
+	OpenMesh::Decimater::ModAspectRatioT<ProxyMesh>::Handle aspectRatio;
+	ModCollapseTrack::Handle track;
+	decimater.add(quadric);
+	decimater.add(normalFlipping);
+	decimater.add(aspectRatio);
+	decimater.add(track);
+	if (!decimater.initialize()) {
+		cerr << "calculateProxyCrossField: the decimater could not be set up" << endl;
+		return false;
+	}
+	decimater.decimate_to_faces(0, proxyFaces);
+
+	// the copy without the removed elements, numbered from 1 like the mesh files
+	CMeshRecords records;
+	std::vector<int> proxyId(om.n_vertices(), -1);
+	for (ProxyMesh::VertexIter vIter = om.vertices_begin(); vIter != om.vertices_end(); ++vIter) {
+		if (om.status(*vIter).deleted()) {
+			continue;
+		}
+		ProxyMesh::Point p = om.point(*vIter);
+		proxyId[vIter->idx()] = (int)records.vertexId.size() + 1;
+		records.vertexId.push_back(proxyId[vIter->idx()]);
+		records.vertexPoint.push_back(CPoint(p[0], p[1], p[2]));
+		records.vertexString.push_back(CTextRange());
+	}
+	for (ProxyMesh::FaceIter fIter = om.faces_begin(); fIter != om.faces_end(); ++fIter) {
+		if (om.status(*fIter).deleted()) {
+			continue;
+		}
+		for (ProxyMesh::FaceVertexIter fvIter = om.fv_iter(*fIter); fvIter.is_valid(); ++fvIter) {
+			records.cornerVertex.push_back(proxyId[fvIter->idx()]);
+		}
+		records.endFace(-1, CTextRange());
+	}
+
+	CToolMesh proxy;
+	if (!proxy.buildFromRecords(records)) {
+		return false;
+	}
+	proxy.labelBoundary();
+	proxy.crossFieldMethod = CROSSFIELD_BUILTIN;
+	proxy.calculateCrossField();
+	if (!proxy.hasCrossField()) {
+		return false;
+	}
+
+	ModCollapseTrack& tracked = decimater.module(track);
+	std::vector<Point> crosses(verts.size());
+	for (size_t i = 0; i < verts.size(); i++) {
+		// zero at a singular vertex, the other corners decide
+		crosses[i] = proxy.vertexCrossField(proxy.idVertex(proxyId[tracked.survivor((int)i)]), 0);
+	}
+
+	// the mean of the crosses of the corners in the frame of the face, by their fourth powers
+	for (FaceIter fIter(this); !fIter.end(); fIter++) {
+		HalfedgeHandle he = faceHalfedge(*fIter);
+		Point x = getPoint(halfedgeTarget(he)) - getPoint(halfedgeSource(he));
+		Point n = x ^ (getPoint(halfedgeTarget(halfedgeNext(he))) - getPoint(halfedgeTarget(he)));
+		x /= x.norm();
+		n /= n.norm();
+		Point y = n ^ x;
+		double sumX = 0, sumY = 0;
+		for (FaceVertexIter fvIter(*fIter); !fvIter.end(); fvIter++) {
+			const Point& cross = crosses[vertexIndex[*fvIter]];
+			if (!(cross.norm() > 0)) {
+				continue;
+			}
+			double a = 4 * atan2(cross * y, cross * x);
+			sumX += cos(a);
+			sumY += sin(a);
+		}
+		std::vector<CPoint>& directions = (*fIter)->crossFieldDirection;
+		directions.clear();
+		if (sumX * sumX + sumY * sumY > 1e-24) {
+			double theta = atan2(sumY, sumX) / 4;
+			directions.push_back(x * cos(theta) + y * sin(theta));
+		}
+	}
+
+	CrossFieldSolver& solver = crossFieldSolver();
+	solver.clearConstraints();
+	solver.addBoundaryConstraints();
+	return solver.refine(proxyRefineIterations);
+}
@@ -126,16 +126,12 @@ VertexHandle CToolMesh::mergeEdge(VertexHandle va, VertexHandle vb) {
 	VertexHandle v1 = halfedgeTarget(halfedgeNext(he1));
 	VertexHandle v2 = halfedgeTarget(halfedgeNext(he2));
 	list<VertexHandle> vbConnectedVertices;
-	map<int, HalfedgeHandle> outwardHeAttributesMap;
-	map<int, HalfedgeHandle> inwardHeAttributesMap;
+	map<int, CToolFrontAttribute> outwardHeAttributesMap;
+	map<int, CToolFrontAttribute> inwardHeAttributesMap;
 	for (VertexIHalfedgeIter vinIter(this, vb); !vinIter.end(); ++vinIter) {
 		if (halfedgeSource(*vinIter) != va && halfedgeSource(*vinIter) != v1 && halfedgeSource(*vinIter) != v2) {
-			HalfedgeHandle outHeAttr = new CToolHalfedge();
-			HalfedgeHandle inHeAttr = new CToolHalfedge();
-			halfedgeSym(*vinIter)->attributeCopyTo(outHeAttr);
-			(*vinIter)->attributeCopyTo(inHeAttr);
-			outwardHeAttributesMap.insert(std::pair<int, HalfedgeHandle>((halfedgeSource(*vinIter))->getId(), outHeAttr));
-			inwardHeAttributesMap.insert(std::pair<int, HalfedgeHandle>((halfedgeSource(*vinIter))->getId(), inHeAttr));
+			outwardHeAttributesMap.insert(std::pair<int, CToolFrontAttribute>((halfedgeSource(*vinIter))->getId(), getFrontAttribute(halfedgeSym(*vinIter))));
+			inwardHeAttributesMap.insert(std::pair<int, CToolFrontAttribute>((halfedgeSource(*vinIter))->getId(), getFrontAttribute(*vinIter)));
 			vbConnectedVertices.push_back(halfedgeSource(*vinIter));
 		}
 	}
@@ -144,10 +140,8 @@ VertexHandle CToolMesh::mergeEdge(VertexHandle va, VertexHandle vb) {
 		splitFace(va, *iter);
 		HalfedgeHandle inwardHe = sourceTargetHalfedge(*iter, va);
 		assert(inwardHe);
-		outwardHeAttributesMap[(*iter)->getId()]->attributeCopyTo(halfedgeSym(inwardHe));
-		inwardHeAttributesMap[(*iter)->getId()]->attributeCopyTo(inwardHe);
-		delete outwardHeAttributesMap[(*iter)->getId()];
-		delete inwardHeAttributesMap[(*iter)->getId()];
+		setFrontAttribute(halfedgeSym(inwardHe), outwardHeAttributesMap[(*iter)->getId()]);
+		setFrontAttribute(inwardHe, inwardHeAttributesMap[(*iter)->getId()]);
 	}
 	return va;
 }
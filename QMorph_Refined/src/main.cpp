@@ -1,32 +1,182 @@
+#include <chrono>
 #include <iostream>
 #include <vector>
 #include "QMorph.h"
 
-int main(int argc, char* argv[]) {
-	CTMesh mesh;
-	// get filename
-	if (argc < 2) {
-		std::cout << "Please input filename" << std::endl;
-		return -1;
+// read a mesh by the extension of the file name
+bool readMesh(CTMesh& mesh, const std::string& filename) {
+	std::string ext = filename.substr(filename.find_last_of(".") + 1);
+	if (ext == "obj") {
+		mesh.read_obj(filename.c_str());
+	}
+	else if (ext == "off") {
+		mesh.read_off(filename.c_str());
+	}
+	else if (ext == "m") {
+		mesh.read_m(filename.c_str());
+	}
+	else if (ext == "qmb") {
+		return mesh.read_qmb(filename.c_str());
 	}
-	// get extension
-	std::string ext = argv[1];
-	std::string name = ext.substr(0, ext.find_last_of("."));
-	ext = ext.substr(ext.find_last_of(".") + 1);
+	else {
+		std::cout << "Unsupported file format" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool writeMesh(CTMesh& mesh, const std::string& filename) {
+	std::string ext = filename.substr(filename.find_last_of(".") + 1);
 	if (ext == "obj") {
-		mesh.read_obj(argv[1]);
+		mesh.write_obj(filename.c_str());
 	}
 	else if (ext == "off") {
-		mesh.read_off(argv[1]);
+		mesh.write_off(filename.c_str());
 	}
 	else if (ext == "m") {
-		mesh.read_m(argv[1]);
+		mesh.write_m(filename.c_str());
+	}
+	else if (ext == "qmb") {
+		return mesh.write_qmb(filename.c_str());
 	}
 	else {
 		std::cout << "Unsupported file format" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool hasOption(int argc, char* argv[], const char* option) {
+	for (int i = 2; i < argc; i++) {
+		if (std::string(argv[i]) == option) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// the number after the option, fallback if it is not given
+int optionValue(int argc, char* argv[], const char* option, int fallback) {
+	for (int i = 2; i + 1 < argc; i++) {
+		if (std::string(argv[i]) == option) {
+			return atoi(argv[i + 1]);
+		}
+	}
+	return fallback;
+}
+
+double optionValue(int argc, char* argv[], const char* option, double fallback) {
+	for (int i = 2; i + 1 < argc; i++) {
+		if (std::string(argv[i]) == option) {
+			return atof(argv[i + 1]);
+		}
+	}
+	return fallback;
+}
+
+// the solver chosen on the command line, libdirectional if none
+void setCrossFieldMethod(CTMesh& mesh, int argc, char* argv[]) {
+	if (hasOption(argc, argv, "--builtin-crossfield")) {
+		mesh.crossFieldMethod = CTMesh::CROSSFIELD_BUILTIN;
+	}
+	if (hasOption(argc, argv, "--proxy-crossfield")) {
+		mesh.crossFieldMethod = CTMesh::CROSSFIELD_PROXY;
+	}
+}
+
+// --convert input output [--crossfield] [--builtin-crossfield | --proxy-crossfield]
+// converts between .m, .obj, .off and .qmb. With --crossfield the cross field is
+// computed and stored, so a run on the .qmb file skips the solve.
+int convert(int argc, char* argv[]) {
+	if (argc < 4) {
+		std::cout << "Usage: " << argv[0] << " --convert input output [--crossfield] [--builtin-crossfield | --proxy-crossfield]" << std::endl;
+		return -1;
+	}
+	CTMesh mesh;
+	if (!readMesh(mesh, argv[2])) {
+		return -1;
+	}
+	setCrossFieldMethod(mesh, argc, argv);
+	if (hasOption(argc, argv, "--crossfield") && !mesh.hasCrossField()) {
+		mesh.calculateCrossField();
+	}
+	return writeMesh(mesh, argv[3]) ? 0 : -1;
+}
+
+// --bench-fronts mesh... [--builtin-crossfield | --proxy-crossfield] [--smooth-band width] [--smooth-threads n] [--smooth-tolerance t]
+// runs QMorph on every mesh once per front loop policy and prints the times,
+// the cross field is solved before the clock starts. With --smooth-band also the
+// vertices the band left out of the smoothing, per front iteration. With
+// --smooth-tolerance also the smoothing sweeps and their largest residual.
+int benchFronts(int argc, char* argv[]) {
+	const FrontLoopRegistry::Policy policies[] = { FrontLoopRegistry::ROUND_ROBIN, FrontLoopRegistry::SMALLEST_FIRST, FrontLoopRegistry::LARGEST_FIRST };
+	const char* policyNames[] = { "round-robin", "smallest-first", "largest-first" };
+	for (int i = 2; i < argc; i++) {
+		if (std::string(argv[i]).compare(0, 2, "--") == 0) {
+			i += std::string(argv[i]) == "--smooth-band" || std::string(argv[i]) == "--smooth-threads"
+				|| std::string(argv[i]) == "--smooth-tolerance";
+			continue;
+		}
+		for (int p = 0; p < 3; p++) {
+			CTMesh mesh;
+			if (!readMesh(mesh, argv[i])) {
+				break;
+			}
+			setCrossFieldMethod(mesh, argc, argv);
+			QMorph qmorph(&mesh);
+			qmorph.setFrontLoopPolicy(policies[p]);
+			qmorph.setSmoothBand(optionValue(argc, argv, "--smooth-band", -1));
+			qmorph.setSmoothThreads(optionValue(argc, argv, "--smooth-threads", 1));
+			qmorph.setSmoothTolerance(optionValue(argc, argv, "--smooth-tolerance", 0.0));
+			int sweeps = 0;
+			double maxResidual = 0;
+			if (hasOption(argc, argv, "--smooth-tolerance")) {
+				qmorph.setSmoothResidualCallback([&](const SmoothResidual& residual) {
+					sweeps++;
+					maxResidual = std::max(maxResidual, residual.maxDisplacement);
+				});
+			}
+			auto start = std::chrono::steady_clock::now();
+			qmorph.doQMorphProcess();
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			std::cout << argv[i] << " " << policyNames[p] << " " << elapsed.count() << " ms, "
+				<< mesh.numFaces() << " faces";
+			if (qmorph.getSmoothBandCount() > 0) {
+				std::cout << ", " << qmorph.getSmoothSavedTotal() / qmorph.getSmoothBandCount()
+					<< " vertices saved per smoothing";
+			}
+			if (sweeps > 0) {
+				std::cout << ", " << sweeps << " smoothing sweeps, residual " << maxResidual;
+			}
+			std::cout << std::endl;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc > 1 && std::string(argv[1]) == "--convert") {
+		return convert(argc, argv);
+	}
+	if (argc > 1 && std::string(argv[1]) == "--bench-fronts") {
+		return benchFronts(argc, argv);
+	}
+	CTMesh mesh;
+	// get filename
+	if (argc < 2) {
+		std::cout << "Please input filename" << std::endl;
 		return -1;
 	}
-	mesh.calculateCrossField();
+	std::string name = argv[1];
+	name = name.substr(0, name.find_last_of("."));
+	if (!readMesh(mesh, argv[1])) {
+		return -1;
+	}
+	// input [--builtin-crossfield | --proxy-crossfield]
+	setCrossFieldMethod(mesh, argc, argv);
+	if (!mesh.hasCrossField()) {
+		mesh.calculateCrossField();
+	}
 	mesh.highlightCrossField();
 	mesh.highlightSingularCrossField();
 	mesh.updateDebug();